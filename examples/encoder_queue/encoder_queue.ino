@@ -0,0 +1,121 @@
+/*
+ * encoder_queue.ino - Example code using the menu system library.
+ *
+ * This example shows a rotary encoder read from an interrupt handler. The
+ * handler only queues events; loop() applies them and renders once per
+ * batch, so no detent is lost while the menu is printed. While a value is
+ * edited, spinning the encoder faster takes larger steps.
+ *
+ * Connect the encoder to pins 2 (A) and 3 (B) and a push button from pin 4
+ * to ground.
+ *
+ * Licensed under the MIT license (see LICENSE)
+ */
+
+#include <MenuSystem.h>
+#include <MenuEventQueue.h>
+#include <MenuAccelerator.h>
+
+const uint8_t ENCODER_A_PIN = 2;
+const uint8_t ENCODER_B_PIN = 3;
+const uint8_t BUTTON_PIN = 4;
+
+// renderer
+
+class MyRenderer : public MenuComponentRenderer {
+public:
+    void render(Menu const& menu) const {
+        Serial.println("");
+        for (int i = 0; i < menu.get_num_components(); ++i) {
+            MenuComponent const* cp_m_comp = menu.get_menu_component(i);
+            cp_m_comp->render(*this);
+
+            if (cp_m_comp->is_current())
+                Serial.print("<<< ");
+            Serial.println("");
+        }
+    }
+
+    void render_menu_item(MenuItem const& menu_item) const {
+        Serial.print(menu_item.get_name());
+    }
+
+    void render_back_menu_item(BackMenuItem const& menu_item) const {
+        Serial.print(menu_item.get_name());
+    }
+
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        menu_item.format_value(buffer, sizeof(buffer));
+        Serial.print(menu_item.get_name());
+        Serial.print(menu_item.has_focus() ? " < " : " = ");
+        Serial.print(buffer);
+    }
+
+    void render_menu(Menu const& menu) const {
+        Serial.print(menu.get_name());
+    }
+};
+MyRenderer my_renderer;
+
+// forward declarations
+
+void on_item_selected(MenuComponent* p_menu_component);
+
+// Menu variables
+
+MenuSystem ms(my_renderer);
+MenuItem mm_mi1("Item 1", &on_item_selected);
+NumericMenuItem mm_mi2("Volume", nullptr, 50, 0, 100, 1);
+NumericMenuItem mm_mi3("Frequency", nullptr, 440, 0, 10000, 1);
+Menu mu1("Submenu");
+BackMenuItem mu1_mi1("Back", nullptr, &ms);
+MenuItem mu1_mi2("Item 2", &on_item_selected);
+
+MenuEventQueue<16> events;
+MenuAccelerator accelerator(250);
+
+// Menu callback function
+
+void on_item_selected(MenuComponent* p_menu_component) {
+    Serial.print(p_menu_component->get_name());
+    Serial.println(" selected");
+}
+
+// Input
+
+void on_encoder_changed() {
+    uint8_t type = digitalRead(ENCODER_B_PIN) ? MenuEvent::EVENT_NEXT : MenuEvent::EVENT_PREV;
+    events.push(type, millis());
+}
+
+void poll_button() {
+    static bool was_pressed = false;
+    bool is_pressed = digitalRead(BUTTON_PIN) == LOW;
+    if (is_pressed && !was_pressed)
+        events.push(MenuEvent::EVENT_SELECT, millis());
+    was_pressed = is_pressed;
+}
+
+// Standard arduino functions
+
+void setup() {
+    Serial.begin(9600);
+
+    pinMode(ENCODER_A_PIN, INPUT_PULLUP);
+    pinMode(ENCODER_B_PIN, INPUT_PULLUP);
+    pinMode(BUTTON_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(ENCODER_A_PIN), on_encoder_changed, FALLING);
+
+    ms.get_root_menu().add_item(&mm_mi1);
+    ms.get_root_menu().add_item(&mm_mi2);
+    ms.get_root_menu().add_item(&mm_mi3);
+    ms.get_root_menu().add_menu(&mu1);
+    mu1.add_item(&mu1_mi1);
+    mu1.add_item(&mu1_mi2);
+}
+
+void loop() {
+    poll_button();
+    events.pump(ms, false, &accelerator);
+}
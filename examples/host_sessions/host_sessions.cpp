@@ -0,0 +1,168 @@
+/*
+ * host_sessions.cpp - Example code using the menu system library.
+ *
+ * This example serves one menu tree to several users from one thread on a
+ * Linux or other POSIX host. The console session reads the keys typed on
+ * stdin; every FIFO named on the command line is another session, fed by
+ * whatever writes to it. All sessions print to stdout, tagged with their
+ * name. A timer updates the uptime once a second. Between events the
+ * program sleeps in poll() and takes no CPU.
+ *
+ *     mkfifo lcd
+ *     ./host_sessions lcd
+ *     printf jjl > lcd          # in another terminal
+ *
+ * Keys: j/k or the arrows move, l or enter selects, h goes back, r resets
+ * and q quits.
+ *
+ * Licensed under the MIT license (see LICENSE)
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <MenuSystem.h>
+#include <MenuSession.h>
+#include <MenuHostLoop.h>
+#include <NumericDisplayMenuItem.h>
+#include <ToggleMenuItem.h>
+
+const int MAX_SESSIONS = 4;
+
+// renderer
+
+class SessionRenderer : public MenuComponentRenderer {
+public:
+    void set_name(const char* name) { _name = name; }
+
+    void render(Menu const& menu) const {
+        printf("[%s] %s\n", _name, menu.get_name());
+        for (int i = 0; i < menu.get_num_components(); ++i) {
+            MenuComponent const* cp_m_comp = menu.get_menu_component(i);
+            printf("[%s] %s ", _name, cp_m_comp->is_current() ? ">" : " ");
+            cp_m_comp->render(*this);
+            printf("%s\n", cp_m_comp->has_focus() ? " <edit>" : "");
+        }
+        fflush(stdout);
+    }
+
+    void render_menu_item(MenuItem const& menu_item) const {
+        printf("%s", menu_item.get_name());
+    }
+
+    void render_back_menu_item(BackMenuItem const& menu_item) const {
+        printf("%s", menu_item.get_name());
+    }
+
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        menu_item.format_value(buffer, sizeof(buffer));
+        printf("%s: %s", menu_item.get_name(), buffer);
+    }
+
+    void render_toggle_menu_item(ToggleMenuItem const& menu_item) const {
+        printf("%s: %s", menu_item.get_name(), menu_item.get_state_str());
+    }
+
+    void render_numeric_display_menu_item(NumericDisplayMenuItem const& menu_item) const {
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        menu_item.format_value(buffer, sizeof(buffer));
+        printf("%s: %s", menu_item.get_name(), buffer);
+    }
+
+    void render_menu(Menu const& menu) const {
+        printf("%s...", menu.get_name());
+    }
+
+private:
+    const char* _name = "";
+};
+
+// Menu variables, shared by all sessions
+
+Menu root_menu("Settings");
+NumericMenuItem mm_brightness("Brightness", nullptr, 50, 0, 100, 5);
+ToggleMenuItem mm_backlight("Backlight", nullptr, "on", "off");
+Menu mu_status("Status");
+// Without a MenuSystem, so it goes back in the session that selects it
+BackMenuItem mu_back("Back", nullptr, nullptr);
+NumericDisplayMenuItem mu_uptime("Uptime (s)", nullptr, 0);
+
+MenuTree tree(root_menu);
+SessionRenderer renderers[MAX_SESSIONS];
+// Unused sessions cost nothing: they never attach to the tree
+MenuSession sessions[MAX_SESSIONS] = {
+    {tree, renderers[0]},
+    {tree, renderers[1]},
+    {tree, renderers[2]},
+    {tree, renderers[3]}
+};
+
+MenuHostLoop host;
+uint32_t start_ms;
+
+// The keys of the console, plus q to quit
+class ConsoleDecoder : public MenuKeyDecoder {
+public:
+    int decode(uint8_t c) {
+        if (c == 'q' || c == 0x03 || c == 0x04) {
+            host.stop();
+            return NO_EVENT;
+        }
+        return MenuKeyDecoder::decode(c);
+    }
+};
+ConsoleDecoder console_decoder;
+
+bool on_tick(void* p_context) {
+    mu_uptime.set_value((MenuHostLoop::now_ms() - start_ms) / 1000);
+    tree.invalidate();
+    return true;
+}
+
+void on_console_closed(int fd, void* p_context) {
+    host.stop();
+}
+
+int main(int argc, char* argv[]) {
+    root_menu.add_item(&mm_brightness);
+    root_menu.add_item(&mm_backlight);
+    root_menu.add_menu(&mu_status);
+    mu_status.add_item(&mu_back);
+    mu_status.add_item(&mu_uptime);
+
+    // Read the keys as they are typed, without echo
+    struct termios saved_tty;
+    bool is_tty = tcgetattr(STDIN_FILENO, &saved_tty) == 0;
+    if (is_tty) {
+        struct termios tty = saved_tty;
+        tty.c_lflag &= ~(ICANON | ECHO | ISIG);
+        tty.c_cc[VMIN] = 1;
+        tty.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &tty);
+    }
+
+    renderers[0].set_name("console");
+    host.add_input(STDIN_FILENO, sessions[0], &console_decoder, &on_console_closed);
+
+    for (int i = 1; i < argc && i < MAX_SESSIONS; ++i) {
+        // Read and write, so the FIFO doesn't end when its writers close it
+        int fd = open(argv[i], O_RDWR);
+        if (fd < 0) {
+            perror(argv[i]);
+            continue;
+        }
+        renderers[i].set_name(argv[i]);
+        host.add_input(fd, sessions[i]);
+    }
+
+    start_ms = MenuHostLoop::now_ms();
+    host.add_timer(1000, &on_tick);
+    host.run();
+
+    if (is_tty)
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved_tty);
+    return 0;
+}
@@ -2,13 +2,15 @@
  * lcd_nav.ino - Example code using the menu system library
  *
  * This example shows using the menu system with a 16x2 LCD display
- * (controled over serial).
+ * (controled over serial). The TextGridRenderer only sends the characters
+ * that changed to the display.
  *
  * Copyright (c) 2015 arduino-menusystem
  * Licensed under the MIT license (see LICENSE)
  */
 
 #include <MenuSystem.h>
+#include <TextGridRenderer.h>
 #include <LiquidCrystal.h>
 
 // renderer
@@ -23,33 +25,20 @@
 //    * LCD R/W pin to ground
 LiquidCrystal lcd = LiquidCrystal(8, 9, 4, 5, 6, 7);
 
-class MyRenderer : public MenuComponentRenderer {
+// Sends the cells that changed since the previous frame to the LCD; the
+// renderer keeps a copy of the screen in RAM, so there's no lcd.clear().
+class LcdBackend : public TextGridBackend {
 public:
-    void render(Menu const& menu) const {
-        lcd.clear();
-        lcd.setCursor(0,0);
-        lcd.print(menu.get_name());
-        lcd.setCursor(0,1);
-        menu.get_current_component()->render(*this);
+    void set_cursor(uint8_t col, uint8_t row) {
+        lcd.setCursor(col, row);
     }
 
-    void render_menu_item(MenuItem const& menu_item) const {
-        lcd.print(menu_item.get_name());
-    }
-
-    void render_back_menu_item(BackMenuItem const& menu_item) const {
-        lcd.print(menu_item.get_name());
-    }
-
-    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {
-        lcd.print(menu_item.get_name());
-    }
-
-    void render_menu(Menu const& menu) const {
-        lcd.print(menu.get_name());
+    void write(const char* text, uint8_t length) {
+        lcd.write((const uint8_t*) text, length);
     }
 };
-MyRenderer my_renderer;
+LcdBackend lcd_backend;
+StaticTextGridRenderer<16, 2> my_renderer(lcd_backend);
 
 // Forward declarations
 
@@ -71,18 +60,21 @@ void on_item1_selected(MenuComponent* p_menu_component) {
     lcd.setCursor(0,1);
     lcd.print("Item1 Selected  ");
     delay(1500); // so we can look the result on the LCD
+    my_renderer.invalidate();
 }
 
 void on_item2_selected(MenuComponent* p_menu_component) {
     lcd.setCursor(0,1);
     lcd.print("Item2 Selected  ");
     delay(1500); // so we can look the result on the LCD
+    my_renderer.invalidate();
 }
 
 void on_item3_selected(MenuComponent* p_menu_component) {
     lcd.setCursor(0,1);
     lcd.print("Item3 Selected  ");
     delay(1500); // so we can look the result on the LCD
+    my_renderer.invalidate();
 }
 
 void serial_print_help() {
@@ -139,6 +131,7 @@ void setup() {
     ms.get_root_menu().add_menu(&mu1);
     mu1.add_item(&mu1_mi1);
 
+    ms.set_viewport(my_renderer.get_num_item_rows());
     ms.display();
 }
 
@@ -10,6 +10,7 @@
 
 #include <ht1632c.h>
 #include <MenuSystem.h>
+#include <MenuAnimation.h>
 
 // Display constants
 
@@ -23,196 +24,145 @@
 ht1632c ledMatrix = ht1632c(&PORTB, PIN_LED_DATA, PIN_LED_WR, PIN_LED_CLOCK,
                             PIN_LED_CS, GEOM_32x16, 2);
 
-class MyRenderer : public MenuComponentRenderer {
+// Transitions are drawn one frame per MenuAnimator::update() call from
+// loop(), so the sketch keeps handling input while the display animates.
+class MyRenderer : public MenuComponentRenderer, public MenuAnimationTarget {
 public:
     MyRenderer()
     : _led_height(16),
       _led_width(32),
       _font_width(5),
       _font_height(7),
-      _color(RED) {
+      _color(RED),
+      _animator(*this) {
     }
 
     void render(Menu const& menu) const {
-        ledMatrix.clear();
-
-        const uint8_t prev_comp_num = menu.get_previous_component_num();
-        _p_prev_comp = menu.get_menu_component(prev_comp_num);
-        auto cp_m_comp = menu.get_current_component();
-        cp_m_comp->render(*this);
+        const menu_index_t prev_comp_num = menu.get_previous_component_num();
+        const menu_index_t curr_comp_num = menu.get_current_component_num();
+        _transition.p_from = menu.get_menu_component(prev_comp_num);
+        _transition.p_to = menu.get_current_component();
+        _transition.easing = EASE_IN_OUT;
+        _slide_direction = curr_comp_num < prev_comp_num
+            ? MenuTransition::EFFECT_SLIDE_DOWN : MenuTransition::EFFECT_SLIDE_UP;
+
+        // The visitor picks the effect
+        _transition.p_to->render(*this);
+        _animator.start(_transition, millis());
     }
 
     void render_menu_item(MenuItem const& menu_item) const {
-        auto prev_name = _p_prev_comp->get_name();
-        auto curr_name = menu_item.get_name();
-        _fade(prev_name, curr_name);
+        _transition.effect = _slide_direction;
+        _transition.duration = 150;
     }
 
     void render_back_menu_item(BackMenuItem const& menu_item) const {
-        auto prev_name = _p_prev_comp->get_name();
-        auto curr_name = menu_item.get_name();
-        _fade(prev_name, curr_name);
+        _transition.effect = MenuTransition::EFFECT_SLIDE_RIGHT;
+        _transition.duration = 300;
     }
 
     void render_numeric_menu_item(NumericMenuItem const& menu_item) const {
-        auto prev_name = _p_prev_comp->get_name();
-        auto curr_name = menu_item.get_name();
-        _fade(prev_name, curr_name);
+        _transition.effect = _slide_direction;
+        _transition.duration = 150;
     }
 
     void render_menu(Menu const& menu) const {
-        auto prev_name = _p_prev_comp->get_name();
-        auto curr_name = menu.get_name();
-        _fade(prev_name, curr_name);
+        _transition.effect = MenuTransition::EFFECT_FADE;
+        _transition.duration = 600;
     }
 
+    void draw_transition(MenuTransition const& transition, uint8_t progress) const {
+        char const* menu1 = transition.p_from->get_name();
+        char const* menu2 = transition.p_to->get_name();
+
+        switch (transition.effect) {
+        case MenuTransition::EFFECT_SLIDE_UP:
+            _vslide(menu1, menu2, VSLIDE_UP, progress);
+            break;
+        case MenuTransition::EFFECT_SLIDE_DOWN:
+            _vslide(menu1, menu2, VSLIDE_DOWN, progress);
+            break;
+        case MenuTransition::EFFECT_SLIDE_LEFT:
+            _hslide(menu1, menu2, HSLIDE_LEFT, progress);
+            break;
+        case MenuTransition::EFFECT_SLIDE_RIGHT:
+            _hslide(menu1, menu2, HSLIDE_RIGHT, progress);
+            break;
+        case MenuTransition::EFFECT_FADE:
+            _fade(menu1, menu2, progress);
+            break;
+        default:
+            _hslide(menu1, menu2, HSLIDE_LEFT, MENU_PROGRESS_END);
+            break;
+        }
+    }
+
+    // Called from loop(); returns true while a transition runs
+    bool update(uint32_t now) const { return _animator.update(now); }
+
 private:
     enum VSlideDirection { VSLIDE_UP, VSLIDE_DOWN };
 
-    void _vslide(char const* menu1, char const* menu2, VSlideDirection d) const {
+    void _vslide(char const* menu1, char const* menu2, VSlideDirection d, uint8_t progress) const {
         // Calculate vertical position
         int menu1_start_y = (_led_height / 2) - (_font_height / 2);
-        int menu2_target_y = menu1_start_y;
-        int menu2_start_y;
+        int offset = menu_lerp(0, _led_height, progress);
+        int menu1_y, menu2_y;
         if (d == VSLIDE_UP) {
-            menu2_start_y = menu1_start_y + _led_height;
+            menu1_y = menu1_start_y - offset;
+            menu2_y = menu1_start_y + _led_height - offset;
         } else {
-            menu2_start_y = menu1_start_y - _led_height;
+            menu1_y = menu1_start_y + offset;
+            menu2_y = menu1_start_y - _led_height + offset;
         }
-        int menu1_y = menu1_start_y;
-        int menu2_y = menu2_start_y;
 
-        // Calculate horizontal position
-        int menu1_text_width = _font_width * strlen(menu1);
-        int menu1_pixel_spare = _led_width - menu1_text_width;
-        int menu1_x_idnt = (int) floor(menu1_pixel_spare / 2);
-
-        int menu2_text_width = _font_width * strlen(menu2);
-        int menu2_pixel_spare = _led_width - menu2_text_width;
-        int menu2_x_idnt = (int) floor(menu2_pixel_spare / 2);
-
-        while (1) {
-            ledMatrix.clear();
-            for (size_t i = 0; i < strlen(menu1); i++) {
-                ledMatrix.putchar(
-                    (i * _font_width) + menu1_x_idnt,
-                    menu1_y, menu1[i], _color
-                );
-            }
-            for (size_t i = 0; i < strlen(menu2); i++) {
-                ledMatrix.putchar(
-                    (i * _font_width) + menu2_x_idnt,
-                    menu2_y, menu2[i], _color
-                );
-            }
-            ledMatrix.sendframe();
-
-            if (menu2_y == menu2_target_y) {
-                break;
-            }
-
-            if (d == VSLIDE_UP) {
-                menu1_y -= 1;
-                menu2_y -= 1;
-            } else {
-                menu1_y += 1;
-                menu2_y += 1;
-            }
-
-            delay(5);
-        }
+        ledMatrix.clear();
+        _draw_text(menu1, _centered_x(menu1), menu1_y);
+        _draw_text(menu2, _centered_x(menu2), menu2_y);
+        ledMatrix.sendframe();
     }
 
     enum HSlideDirection { HSLIDE_LEFT, HSLIDE_RIGHT };
 
-    void _hslide(char const* menu1, char const* menu2, HSlideDirection d) const {
+    void _hslide(char const* menu1, char const* menu2, HSlideDirection d, uint8_t progress) const {
         // Calculate vertical position
         int y_idnt = (_led_height / 2) - (_font_height / 2);
 
         // Calculate horizontal position
-        int menu1_text_width = _font_width * strlen(menu1);
-        int menu1_pixel_spare = _led_width - menu1_text_width;
-        int menu1_start_x = (int) floor(menu1_pixel_spare / 2);
-        int menu2_text_width = _font_width * strlen(menu2);
-        int menu2_pixel_spare = _led_width - menu2_text_width;
-        int menu2_target_x = (int) floor(menu2_pixel_spare / 2);
-        int menu2_start_x;
+        int offset = menu_lerp(0, _led_width, progress);
+        int menu1_x, menu2_x;
         if (d == HSLIDE_LEFT) {
-            menu2_start_x = menu1_start_x + _led_width;
+            menu1_x = _centered_x(menu1) - offset;
+            menu2_x = _centered_x(menu2) + _led_width - offset;
         } else {
-            menu2_start_x = menu1_start_x - _led_width;
-        }
-        int menu1_x = menu1_start_x;
-        int menu2_x = menu2_start_x;
-
-        while (1) {
-            ledMatrix.clear();
-            for (size_t i = 0; i < strlen(menu1); i++) {
-                ledMatrix.putchar(
-                    (i * _font_width) + menu1_x,
-                    y_idnt, menu1[i], _color
-                );
-            }
-            for (size_t i = 0; i < strlen(menu2); i++) {
-                ledMatrix.putchar(
-                    (i * _font_width) + menu2_x,
-                    y_idnt, menu2[i], _color
-                );
-            }
-            ledMatrix.sendframe();
-
-            if (menu2_x == menu2_target_x) {
-                break;
-            }
-
-            if (d == HSLIDE_LEFT) {
-                menu1_x -= 1;
-                menu2_x -= 1;
-            } else {
-                menu1_x += 1;
-                menu2_x += 1;
-            }
-
-            delay(5);
+            menu1_x = _centered_x(menu1) + offset;
+            menu2_x = _centered_x(menu2) - _led_width + offset;
         }
+
+        ledMatrix.clear();
+        _draw_text(menu1, menu1_x, y_idnt);
+        _draw_text(menu2, menu2_x, y_idnt);
+        ledMatrix.sendframe();
     }
 
-    void _fade(char const* menu1, char const* menu2) const {
+    void _fade(char const* menu1, char const* menu2, uint8_t progress) const {
         int y_idnt = (_led_height / 2) - (_font_height / 2);
+        char const* menu = menu_fade_shows_to(progress) ? menu2 : menu1;
 
-        int menu1_text_width = _font_width * strlen(menu1);
-        int menu1_pixel_spare = _led_width - menu1_text_width;
-        int menu1_x_idnt = (int) floor(menu1_pixel_spare / 2);
-        for (size_t i = 0; i < strlen(menu1); i++) {
-            ledMatrix.putchar(
-                (i * _font_width) + menu1_x_idnt,
-                y_idnt, menu1[i], _color
-            );
-        }
+        ledMatrix.clear();
+        _draw_text(menu, _centered_x(menu), y_idnt);
         ledMatrix.sendframe();
+        ledMatrix.pwm(menu_fade_level(10, progress));
+    }
 
-        int brightness = 10;
-        while (brightness > 0) {
-            ledMatrix.pwm(--brightness);
-            delay(30);
-        }
-        ledMatrix.clear();
+    int _centered_x(char const* text) const {
+        int text_width = _font_width * strlen(text);
+        return (_led_width - text_width) / 2;
+    }
 
-        int menu2_text_width = _font_width * strlen(menu2);
-        int menu2_pixel_spare = _led_width - menu2_text_width;
-        int menu2_x_idnt = (int) floor(menu2_pixel_spare / 2);
-        for (size_t i = 0; i < strlen(menu2); i++) {
-            ledMatrix.putchar(
-                (i * _font_width) + menu2_x_idnt,
-                y_idnt, menu2[i], _color
-            );
-        }
-        ledMatrix.sendframe();
-        delay(30);
-        while (brightness < 10) {
-            ledMatrix.pwm(++brightness);
-            delay(30);
-        }
+    void _draw_text(char const* text, int x, int y) const {
+        for (size_t i = 0; i < strlen(text); i++)
+            ledMatrix.putchar((i * _font_width) + x, y, text[i], _color);
     }
 
 private:
@@ -222,7 +172,9 @@ private:
     const uint8_t _font_height;
     const uint8_t _color;
 
-    mutable MenuComponent const* _p_prev_comp;
+    mutable MenuTransition _transition;
+    mutable uint8_t _slide_direction;
+    mutable MenuAnimator _animator;
 };
 MyRenderer my_renderer;
 
@@ -248,7 +200,15 @@ void setup() {
 }
 
 void loop() {
-    ms.next(true);
-    ms.display();
-    delay(1000);
+    static uint32_t last_step = 0;
+    uint32_t now = millis();
+
+    // Step through the menu once a second without blocking the animation
+    if (now - last_step >= 1000) {
+        last_step = now;
+        ms.next(true);
+        ms.display();
+    }
+
+    my_renderer.update(now);
 }
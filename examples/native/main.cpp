@@ -16,12 +16,43 @@ void loop();
 #endif
 
 #if ! defined(ARDUINO)
+#include <MenuHostLoop.h>
+
+#ifndef NATIVE_LOOP_INTERVAL_MS
+// How often loop() runs on its own, for the sketches that animate; 0 runs
+// it only on input. Sketches pace themselves with delay() on the boards
+// only, so calling loop() back to back would spin a core.
+#define NATIVE_LOOP_INTERVAL_MS 2000
+#endif
+
+// A stopgap for running sketches unchanged: the sketches don't read the
+// host's input, so a line typed on stdin just runs loop() once more, and
+// the timer runs it otherwise. Host programs that want their input and no
+// CPU while idle drive their menus with MenuHostLoop directly, see the
+// host_sessions example.
+static bool run_loop(void* p_context)
+{
+  loop();
+  return true;
+}
+
+static bool on_stdin(int fd, void* p_context)
+{
+  char buffer[64];
+  if (read(fd, buffer, sizeof(buffer)) <= 0)
+    return false;
+  loop();
+  return true;
+}
+
 int main(void)
 {
   setup();
-  while(1) {
-    loop();
-  }
+  MenuHostLoop host;
+  host.add_reader(STDIN_FILENO, &on_stdin);
+  if (NATIVE_LOOP_INTERVAL_MS > 0)
+    host.add_timer(NATIVE_LOOP_INTERVAL_MS, &run_loop);
+  host.run();
+  return 0;
 }
 #endif
-
@@ -6,13 +6,10 @@ CustomNumericMenuItem::CustomNumericMenuItem(
 : NumericMenuItem(name, nullptr, value, minValue, maxValue, increment,
                   on_format_value),
   _width(width) {
+    // Lets MyRenderer tell this item apart from other NumericMenuItems
+    set_type(TYPE);
 }
 
 uint8_t CustomNumericMenuItem::get_width() const {
     return _width;
 }
-
-void CustomNumericMenuItem::render(MenuComponentRenderer const& renderer) const {
-    MyRenderer const& my_renderer = static_cast<MyRenderer const&>(renderer);
-    my_renderer.render_custom_numeric_menu_item(*this);
-}
@@ -11,12 +11,12 @@
 #define _CUSTOMNUMERICMENUITEM_H
 
 #include <MenuSystem.h>
-#include "MyRenderer.h"
-
-class MyRenderer;
 
 class CustomNumericMenuItem : public NumericMenuItem {
 public:
+    //! The MenuComponent::Type of CustomNumericMenuItem
+    static const uint8_t TYPE = TYPE_USER;
+
     /**
      * @param width the width of the edit mode 'ASCII graphics', must be > 1
      * @param name The name of the menu item.
@@ -33,8 +33,6 @@ public:
 
     uint8_t get_width() const;
 
-    virtual void render(MenuComponentRenderer const& renderer) const;
-
 private:
     const uint8_t _width;
 };
@@ -3,10 +3,9 @@
 void MyRenderer::render(Menu const& menu) const {
     Serial.print("\nCurrent menu name: ");
     Serial.println(menu.get_name());
-    String buffer;
     for (int i = 0; i < menu.get_num_components(); ++i) {
         MenuComponent const* cp_m_comp = menu.get_menu_component(i);
-        cp_m_comp->render(*this);
+        render_component(*cp_m_comp);
 
         if (cp_m_comp->is_current())
             Serial.print("<<< ");
@@ -14,34 +13,31 @@ void MyRenderer::render(Menu const& menu) const {
     }
 }
 
-void MyRenderer::render_menu_item(MenuItem const& menu_item) const {
-    Serial.print(menu_item.get_name());
-}
-
-void MyRenderer::render_back_menu_item(BackMenuItem const& menu_item) const {
-    Serial.print(menu_item.get_name());
+void MyRenderer::draw_component(MenuComponent const& component) const {
+    if (component.get_type() == CustomNumericMenuItem::TYPE)
+        draw_custom_numeric_menu_item(static_cast<CustomNumericMenuItem const&>(component));
+    else
+        Serial.print(component.get_name());
 }
 
-void MyRenderer::render_numeric_menu_item(NumericMenuItem const& menu_item) const {
-    String buffer;
+void MyRenderer::draw_numeric_menu_item(NumericMenuItem const& menu_item) const {
+    // Format into a stack buffer so rendering doesn't touch the heap
+    char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+    menu_item.format_value(buffer, sizeof(buffer));
 
-    buffer = menu_item.get_name();
-    buffer += menu_item.has_focus() ? '<' : '=';
-    buffer += menu_item.get_formatted_value();
+    Serial.print(menu_item.get_name());
+    Serial.print(menu_item.has_focus() ? '<' : '=');
+    Serial.print(buffer);
 
     if (menu_item.has_focus())
-        buffer += '>';
-
-    Serial.print(buffer);
+        Serial.print('>');
 }
 
-void MyRenderer::render_custom_numeric_menu_item(CustomNumericMenuItem const& menu_item) const {
+void MyRenderer::draw_custom_numeric_menu_item(CustomNumericMenuItem const& menu_item) const {
     // This condition can be put in the CustomNumericMenuItem class as well
     if (menu_item.has_focus()) {
         // Only display the ASCII graphics in edit mode.
 
-        String buffer;
-
         // make room for a ' ' at the end and the terminating 0
         char graphics[menu_item.get_width() + 2];
 
@@ -57,17 +53,11 @@ void MyRenderer::render_custom_numeric_menu_item(CustomNumericMenuItem const& me
             )] = '|';
         graphics[menu_item.get_width()] = ' ';
         graphics[menu_item.get_width() + 1] = 0;
-        buffer = graphics;
 
-        buffer += menu_item.get_value();
-
-        Serial.println(buffer);
+        Serial.print(graphics);
+        Serial.println(menu_item.get_value());
     } else {
         // Non edit mode: Let parent class handle this
-        return render_numeric_menu_item(menu_item);
+        return draw_numeric_menu_item(menu_item);
     }
 }
-
-void MyRenderer::render_menu(Menu const& menu) const {
-    Serial.print(menu.get_name());
-}
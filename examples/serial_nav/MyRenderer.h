@@ -11,18 +11,17 @@
 #define _MY_RENDERER_H
 
 #include <MenuSystem.h>
+#include <StaticMenuRenderer.h>
 #include "CustomNumericMenuItem.h"
 
-class CustomNumericMenuItem;
-
-class MyRenderer : public MenuComponentRenderer {
+// Only the hooks that differ are implemented; menus, back items and the
+// other items are drawn by draw_component.
+class MyRenderer : public StaticMenuRenderer<MyRenderer> {
 public:
     void render(Menu const& menu) const;
-    void render_menu_item(MenuItem const& menu_item) const;
-    void render_back_menu_item(BackMenuItem const& menu_item) const;
-    void render_numeric_menu_item(NumericMenuItem const& menu_item) const;
-    void render_custom_numeric_menu_item(CustomNumericMenuItem const& menu_item) const;
-    void render_menu(Menu const& menu) const;
+    void draw_component(MenuComponent const& component) const;
+    void draw_numeric_menu_item(NumericMenuItem const& menu_item) const;
+    void draw_custom_numeric_menu_item(CustomNumericMenuItem const& menu_item) const;
 };
 
 #endif
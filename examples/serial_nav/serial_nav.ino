@@ -12,9 +12,9 @@
 #include "MyRenderer.h"
 
 // forward declarations
-const String format_float(const float value);
-const String format_int(const float value);
-const String format_color(const float value);
+void format_float(const float value, char* buffer, size_t size);
+void format_int(const float value, char* buffer, size_t size);
+void format_color(const float value, char* buffer, size_t size);
 void on_component_selected(MenuComponent* p_menu_component);
 
 // Menu variables
@@ -27,43 +27,43 @@ MenuItem mm_mi2("Level 1 - Item 2 (Item)", &on_component_selected);
 Menu mu1("Level 1 - Item 3 (Menu)");
 BackMenuItem mu1_mi0("Level 2 - Back (Item)", &on_component_selected, &ms);
 MenuItem mu1_mi1("Level 2 - Item 1 (Item)", &on_component_selected);
-NumericMenuItem mu1_mi2("Level 2 - Txt Item 2 (Item)", nullptr, 0, 0, 2, 1, format_color);
-CustomNumericMenuItem mu1_mi3(12, "Level 2 - Cust Item 3 (Item)", 80, 65, 121, 3, format_int);
-NumericMenuItem mm_mi4("Level 1 - Float Item 4 (Item)", nullptr, 0.5, 0.0, 1.0, 0.1, format_float);
-NumericMenuItem mm_mi5("Level 1 - Int Item 5 (Item)", nullptr, 50, -100, 100, 1, format_int);
+NumericMenuItem mu1_mi2("Level 2 - Txt Item 2 (Item)", nullptr, 0, 0, 2, 1);
+CustomNumericMenuItem mu1_mi3(12, "Level 2 - Cust Item 3 (Item)", 80, 65, 121, 3);
+NumericMenuItem mm_mi4("Level 1 - Float Item 4 (Item)", nullptr, 0.5, 0.0, 1.0, 0.1);
+NumericMenuItem mm_mi5("Level 1 - Int Item 5 (Item)", nullptr, 50, -100, 100, 1);
 
 // Menu callback function
 
 // writes the (int) value of a float into a char buffer.
-const String format_int(const float value) {
-    return String((int) value);
+void format_int(const float value, char* buffer, size_t size) {
+    snprintf(buffer, size, "%d", (int) value);
 }
 
 // writes the value of a float into a char buffer.
-const String format_float(const float value) {
-    return String(value);
+void format_float(const float value, char* buffer, size_t size) {
+    menu_format_float(value, buffer, size);
 }
 
 // writes the value of a float into a char buffer as predefined colors.
-const String format_color(const float value) {
-    String buffer;
+void format_color(const float value, char* buffer, size_t size) {
+    const char* name;
 
     switch((int) value)
     {
         case 0:
-            buffer += "Red";
+            name = "Red";
             break;
         case 1:
-            buffer += "Green";
+            name = "Green";
             break;
         case 2:
-            buffer += "Blue";
+            name = "Blue";
             break;
         default:
-            buffer += "undef";
+            name = "undef";
     }
 
-    return buffer;
+    menu_copy_string(name, buffer, size);
 }
 
 // In this example all menu items use the same callback.
@@ -124,6 +124,11 @@ void serial_handler() {
 void setup() {
     Serial.begin(9600);
 
+    mu1_mi2.set_value_formatter(format_color);
+    mu1_mi3.set_value_formatter(format_int);
+    mm_mi4.set_value_formatter(format_float);
+    mm_mi5.set_value_formatter(format_int);
+
     ms.get_root_menu().add_item(&mm_mi1);
     ms.get_root_menu().add_item(&mm_mi2);
     ms.get_root_menu().add_menu(&mu1);
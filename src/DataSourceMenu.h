@@ -0,0 +1,320 @@
+/**
+ * \file    DataSourceMenu.h
+ * \brief   DataSourceMenu, a Menu whose items are generated on demand
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef DATA_SOURCE_MENU_H
+#define DATA_SOURCE_MENU_H
+
+#include "MenuSystem.h"
+
+#ifndef MENUSYSTEM_DATA_NAME_SIZE
+//! The size of the name buffer of a DataSourceMenuItem, including the '\0'
+#define MENUSYSTEM_DATA_NAME_SIZE 20
+#endif
+
+class DataSourceMenu;
+
+//! \brief A slot of a DataSourceMenu
+//!
+//! A slot shows one item of the data source at a time: its name is filled
+//! in by the data source when the slot scrolls onto a new item. Slots are
+//! rendered with MenuComponentRenderer::render_menu_item like any other
+//! MenuItem.
+//!
+//! \see DataSourceMenu
+class DataSourceMenuItem : public MenuItem {
+    friend class DataSourceMenu;
+public:
+    DataSourceMenuItem()
+    : MenuItem(_name_buffer, nullptr),
+    _p_menu(nullptr),
+    _index(0) {
+        _name_buffer[0] = '\0';
+    }
+
+    //! \returns The index of the item shown in this slot.
+    uint16_t get_index() const { return _index; }
+
+    //! \returns The DataSourceMenu this slot belongs to.
+    DataSourceMenu const* get_menu() const { return _p_menu; }
+
+protected:
+    //! \copydoc MenuComponent::select
+    //!
+    //! Calls the select function of the DataSourceMenu with the index of the
+    //! item shown in this slot.
+    virtual Menu* select();
+
+private:
+    DataSourceMenu* _p_menu;
+    uint16_t _index;
+    char _name_buffer[MENUSYSTEM_DATA_NAME_SIZE];
+};
+
+//! \brief A Menu backed by a data source instead of a list of components
+//!
+//! The items of a DataSourceMenu are described by two callbacks: one that
+//! returns the number of items and one that writes the name of the item at
+//! an index. Only a window of items is materialized, into a small pool of
+//! DataSourceMenuItem slots that is refilled as the cursor scrolls, so lists
+//! such as file listings or Wi-Fi scan results cost a few slots of RAM no
+//! matter how long they are. A DataSourceMenu holds up to 65535 items.
+//!
+//! To the renderer a DataSourceMenu is a Menu of its slots: get_num_components
+//! and get_current_component_num refer to the window, get_item_num maps a
+//! slot to the index of its item. Use as many slots as the display has rows.
+//!
+//! The items are counted again each time the menu is entered; call refresh()
+//! (and MenuSystem::invalidate) when the data changes while it's shown.
+//!
+//! \code
+//! uint16_t count_networks(DataSourceMenu const& menu) { return WiFi.scanComplete(); }
+//! void get_network(DataSourceMenu const& menu, uint16_t index, char* buffer, size_t size) {
+//!     strncpy(buffer, WiFi.SSID(index).c_str(), size);
+//! }
+//! Menu* on_network_selected(DataSourceMenu& menu, uint16_t index) { ...; return nullptr; }
+//!
+//! StaticDataSourceMenu<4> mu_wifi("Wi-Fi", &count_networks, &get_network,
+//!                                 &on_network_selected);
+//! \endcode
+//!
+//! \see StaticDataSourceMenu
+class DataSourceMenu : public Menu {
+public:
+    //! \brief Returns the number of items in the data source
+    using CountFnPtr = uint16_t (*)(DataSourceMenu const& menu);
+
+    //! \brief Writes the name of the item at index into buffer
+    //!
+    //! The name is truncated to size - 1 characters; buffer must be '\0'
+    //! terminated.
+    using ItemFnPtr = void (*)(DataSourceMenu const& menu, uint16_t index,
+                               char* buffer, size_t size);
+
+    //! \brief Called when the item at index is selected
+    //!
+    //! \returns A Menu to enter or nullptr. The returned Menu becomes a child
+    //!          of this menu, so MenuSystem::back returns here.
+    using ItemSelectFnPtr = Menu* (*)(DataSourceMenu& menu, uint16_t index);
+
+    //! \returns The number of items in the data source.
+    uint16_t get_num_items() const { return _num_items; }
+
+    //! \returns The index of the item in the first slot.
+    uint16_t get_first_item_num() const { return _offset; }
+
+    //! \returns The index of the current item.
+    uint16_t get_current_item_num() const { return _offset + get_current_component_num(); }
+
+    //! \returns The index of the item shown in slot.
+    uint16_t get_item_num(uint8_t slot) const { return _offset + slot; }
+
+    //! \brief Counts the items again and refills the slots
+    //!
+    //! The cursor stays on the same index, or on the last item if the list
+    //! got shorter.
+    void refresh() {
+        uint16_t index = get_current_item_num();
+        _num_items = _count_fn != nullptr ? _count_fn(*this) : 0;
+
+        uint8_t num_slots = _num_items < _num_slots ? _num_items : _num_slots;
+        if (index >= _num_items)
+            index = _num_items ? _num_items - 1 : 0;
+        if (_offset > _num_items - num_slots)
+            _offset = _num_items - num_slots;
+        if (index < _offset)
+            _offset = index;
+        else if (index >= _offset + num_slots)
+            _offset = index - num_slots + 1;
+
+        for (uint8_t i = 0; i < _num_slots; ++i) {
+            _p_slots[i]._p_menu = this;
+            _p_storage[i] = &_p_slots[i];
+        }
+        set_num_components(num_slots);
+        fill();
+        if (num_slots)
+            Menu::move_to(index - _offset);
+        _window_moved = true;
+    }
+
+protected:
+    //! \param[in] p_slots The slots to show the items in.
+    //! \param[in] p_storage An array of num_slots component pointers.
+    //! \param[in] num_slots The number of elements in p_slots and p_storage.
+    DataSourceMenu(const char* name, CountFnPtr count_fn, ItemFnPtr item_fn,
+                   ItemSelectFnPtr item_select_fn, DataSourceMenuItem* p_slots,
+                   MenuComponent** p_storage, uint8_t num_slots)
+    : Menu(name, nullptr, p_storage, num_slots),
+    _count_fn(count_fn),
+    _item_fn(item_fn),
+    _item_select_fn(item_select_fn),
+    _p_slots(p_slots),
+    _p_storage(p_storage),
+    _num_items(0),
+    _offset(0),
+    _num_slots(num_slots),
+    _window_moved(false) {
+    }
+
+    //! \copydoc Menu::enter
+    //!
+    //! Counts the items of the data source.
+    virtual void enter() {
+        apply_reset();
+        refresh();
+        Menu::enter();
+    }
+
+    //! \copydoc Menu::move_by
+    virtual bool move_by(int16_t delta, bool loop=false) {
+        if (!_num_items)
+            return false;
+
+        int32_t index = (int32_t) get_current_item_num() + delta;
+        if (loop) {
+            index %= _num_items;
+            if (index < 0)
+                index += _num_items;
+        } else if (index < 0) {
+            index = 0;
+        } else if (index >= _num_items) {
+            index = _num_items - 1;
+        }
+        return move_to_item((uint16_t) index);
+    }
+
+    //! \copydoc Menu::move_to_end
+    virtual bool move_to_end(bool last) {
+        if (!_num_items)
+            return false;
+        return move_to_item(last ? _num_items - 1 : 0);
+    }
+
+    //! \copydoc Menu::scroll_to_current
+    //!
+    //! Also reports when the slots were refilled with other items.
+    virtual bool scroll_to_current(uint8_t rows, uint8_t policy) {
+        bool scrolled = Menu::scroll_to_current(rows, policy);
+        if (_window_moved) {
+            _window_moved = false;
+            return true;
+        }
+        return scrolled;
+    }
+
+    //! \copydoc MenuComponent::save_state
+    //!
+    //! The items change between boots, so a DataSourceMenu has no state.
+    virtual uint8_t save_state(uint8_t* buffer, uint8_t size) const { return 0; }
+
+    //! \copydoc Menu::get_cursor_position
+    //!
+    //! The position is the index of the current item.
+    virtual uint16_t get_cursor_position() const { return get_current_item_num(); }
+
+    //! \copydoc Menu::set_cursor_position
+    virtual bool set_cursor_position(uint16_t position) {
+        if (position >= _num_items)
+            return false;
+        move_to_item(position);
+        return true;
+    }
+
+    //! \copydoc Menu::reset_state
+    virtual void reset_state() {
+        _offset = 0;
+        Menu::reset_state();
+        fill();
+        _window_moved = true;
+    }
+
+    //! \brief Makes the item at index the current one
+    //!
+    //! The window of slots is moved just enough to show the item.
+    //!
+    //! \returns true if the cursor moved, false otherwise.
+    bool move_to_item(uint16_t index) {
+        if (index >= _num_items)
+            return false;
+
+        uint8_t num_slots = get_num_components();
+        uint16_t offset = _offset;
+        if (index < offset)
+            offset = index;
+        else if (index >= offset + num_slots)
+            offset = index - num_slots + 1;
+
+        bool window_moved = offset != _offset;
+        if (window_moved) {
+            _offset = offset;
+            _window_moved = true;
+            fill();
+        }
+        return Menu::move_to(index - _offset) || window_moved;
+    }
+
+private:
+    friend class DataSourceMenuItem;
+
+    void fill() {
+        for (uint8_t i = 0; i < get_num_components(); ++i) {
+            DataSourceMenuItem& slot = _p_slots[i];
+            slot._index = _offset + i;
+            slot._name_buffer[0] = '\0';
+            if (_item_fn != nullptr)
+                _item_fn(*this, slot._index, slot._name_buffer, sizeof(slot._name_buffer));
+            slot._name_buffer[sizeof(slot._name_buffer) - 1] = '\0';
+        }
+    }
+
+    Menu* select_item(uint16_t index) {
+        if (_item_select_fn == nullptr)
+            return nullptr;
+
+        Menu* p_menu = _item_select_fn(*this, index);
+        if (p_menu != nullptr)
+            p_menu->set_parent(this);
+        return p_menu;
+    }
+
+private:
+    CountFnPtr _count_fn;
+    ItemFnPtr _item_fn;
+    ItemSelectFnPtr _item_select_fn;
+    DataSourceMenuItem* _p_slots;
+    MenuComponent** _p_storage;
+    uint16_t _num_items;
+    uint16_t _offset;
+    uint8_t _num_slots;
+    bool _window_moved;
+};
+
+//! \brief A DataSourceMenu with N slots stored inline
+//!
+//! \tparam N The number of slots, usually the number of rows of the display.
+//!
+//! \see DataSourceMenu
+template <uint8_t N>
+class StaticDataSourceMenu : public DataSourceMenu {
+    static_assert(N > 0, "StaticDataSourceMenu needs at least one slot");
+public:
+    StaticDataSourceMenu(const char* name, CountFnPtr count_fn, ItemFnPtr item_fn,
+                         ItemSelectFnPtr item_select_fn=nullptr)
+    : DataSourceMenu(name, count_fn, item_fn, item_select_fn, _slots, _components, N) {
+    }
+
+private:
+    DataSourceMenuItem _slots[N];
+    MenuComponent* _components[N];
+};
+
+inline Menu* DataSourceMenuItem::select() {
+    MenuItem::select();
+    return _p_menu != nullptr ? _p_menu->select_item(_index) : nullptr;
+}
+
+#endif // DATA_SOURCE_MENU_H
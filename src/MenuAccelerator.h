@@ -0,0 +1,169 @@
+/**
+ * \file    MenuAccelerator.h
+ * \brief   MenuAccelerator, turns fast encoder input into larger steps
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef MENU_ACCELERATOR_H
+#define MENU_ACCELERATOR_H
+
+#include "MenuSystem.h"
+
+//! \brief An acceleration curve that grows linearly with the speed
+//!
+//! \param[in] speed From 0, the slowest input that is accelerated, to 255,
+//!                  the fastest.
+//! \param[in] max_multiplier The multiplier at speed 255.
+//! \returns The multiplier, 1 to max_multiplier.
+inline uint16_t menu_accel_linear(uint8_t speed, uint16_t max_multiplier) {
+    return 1 + (uint32_t) (max_multiplier - 1) * speed / 255;
+}
+
+//! \brief An acceleration curve that stays low at moderate speeds
+//! \copydetails menu_accel_linear
+inline uint16_t menu_accel_quadratic(uint8_t speed, uint16_t max_multiplier) {
+    return 1 + (uint32_t) (max_multiplier - 1) * speed * speed / (255 * 255);
+}
+
+//! \brief Scales the steps of a rotary encoder with its speed
+//!
+//! Each detent is passed to accelerate() with the time it happened, taken
+//! by the caller, e.g. from millis() or MenuEvent::time. Turning slowly
+//! steps one at a time; the faster the detents come, the larger the
+//! multiplier, up to the maximum. The multiplier at most doubles from one
+//! detent to the next so it ramps up smoothly, and drops back to 1 when the
+//! input pauses or changes direction. With a maximum of 250, sweeping a
+//! range of 0 to 10000 takes three spins of a 24 detent encoder, and since
+//! MenuSystem::move_by records a single change per call, there's one redraw
+//! per batch of detents rather than one per step.
+//!
+//! \code
+//! MenuAccelerator accelerator;
+//!
+//! void on_detent(int8_t direction) {
+//!     ms.move_by(accelerator.accelerate(direction, millis()));
+//!     ms.display();
+//! }
+//! \endcode
+//!
+//! Meant for editing values; MenuEventQueue::pump only accelerates while
+//! the current component has focus.
+//!
+//! \see MenuEventQueue::pump
+class MenuAccelerator {
+public:
+    //! \brief Maps a speed from 0 to 255 to a multiplier
+    //! \see menu_accel_linear
+    using CurveFnPtr = uint16_t (*)(uint8_t speed, uint16_t max_multiplier);
+
+public:
+    //! \param[in] max_multiplier The largest multiplier.
+    //! \param[in] slow_ms Detents at least this far apart aren't accelerated.
+    //! \param[in] fast_ms Detents at most this far apart get max_multiplier.
+    //! \param[in] curve The acceleration curve.
+    MenuAccelerator(uint16_t max_multiplier=100, uint16_t slow_ms=100,
+                    uint16_t fast_ms=5, CurveFnPtr curve=&menu_accel_quadratic)
+    : _curve(curve),
+    _last_time(0),
+    _interval(slow_ms),
+    _max_multiplier(max_multiplier ? max_multiplier : 1),
+    _multiplier(1),
+    _slow_ms(slow_ms),
+    _fast_ms(fast_ms < slow_ms ? fast_ms : slow_ms),
+    _direction(0),
+    _snap(false) {
+    }
+
+    void set_curve(CurveFnPtr curve) { _curve = curve; }
+    void set_max_multiplier(uint16_t max_multiplier) { _max_multiplier = max_multiplier ? max_multiplier : 1; }
+    uint16_t get_max_multiplier() const { return _max_multiplier; }
+
+    //! \brief Sets the intervals between detents that bound the acceleration
+    //!
+    //! Forgets the previous detents, which were measured against the old
+    //! intervals.
+    void set_timing(uint16_t slow_ms, uint16_t fast_ms) {
+        _slow_ms = slow_ms;
+        _fast_ms = fast_ms < slow_ms ? fast_ms : slow_ms;
+        reset();
+    }
+
+    //! \brief Rounds the multiplier down to 1, 2, 5, 10, 20, 50...
+    //!
+    //! Steps are always whole multiples of the increment of the item; with
+    //! snap the multiples are round too, so fast sweeps land on round
+    //! values when they start from one.
+    void set_snap(bool snap) { _snap = snap; }
+
+    //! \returns The multiplier of the last detent.
+    uint16_t get_multiplier() const { return _multiplier; }
+
+    //! \brief Records a detent and returns the steps it's worth
+    //!
+    //! \param[in] direction 1 for next, -1 for prev.
+    //! \param[in] time When the detent happened in milliseconds; may wrap
+    //!                 around.
+    //! \returns direction times the multiplier.
+    int16_t accelerate(int8_t direction, uint32_t time) {
+        uint32_t elapsed = time - _last_time;
+        _last_time = time;
+
+        if (direction != _direction || elapsed >= _slow_ms) {
+            _direction = direction;
+            _interval = _slow_ms;
+            _multiplier = 1;
+            return direction;
+        }
+
+        // Smoothed, so a single early or late detent doesn't make it jump
+        _interval = (uint16_t) (((uint32_t) _interval + elapsed) / 2);
+
+        uint8_t speed = 255;
+        if (_interval > _fast_ms)
+            speed = (uint8_t) ((uint32_t) 255 * (_slow_ms - _interval) / (_slow_ms - _fast_ms));
+
+        uint16_t multiplier = _curve != nullptr ? _curve(speed, _max_multiplier) : 1;
+        if (multiplier > 2 * (uint32_t) _multiplier)
+            multiplier = 2 * _multiplier;
+        if (multiplier > _max_multiplier)
+            multiplier = _max_multiplier;
+        if (multiplier < 1)
+            multiplier = 1;
+        if (_snap)
+            multiplier = snap(multiplier);
+        _multiplier = multiplier;
+
+        int32_t steps = (int32_t) direction * multiplier;
+        return steps > INT16_MAX ? INT16_MAX : (steps < -INT16_MAX ? -INT16_MAX : (int16_t) steps);
+    }
+
+    //! \brief Forgets the previous detents; the next one steps by 1
+    void reset() {
+        _direction = 0;
+        _interval = _slow_ms;
+        _multiplier = 1;
+    }
+
+private:
+    static uint16_t snap(uint16_t multiplier) {
+        uint16_t decade = 1;
+        while (multiplier / decade >= 10)
+            decade *= 10;
+        uint16_t digit = multiplier / decade;
+        return (digit >= 5 ? 5 : digit >= 2 ? 2 : 1) * decade;
+    }
+
+private:
+    CurveFnPtr _curve;
+    uint32_t _last_time;
+    uint16_t _interval;
+    uint16_t _max_multiplier;
+    uint16_t _multiplier;
+    uint16_t _slow_ms;
+    uint16_t _fast_ms;
+    int8_t _direction;
+    bool _snap;
+};
+
+#endif // MENU_ACCELERATOR_H
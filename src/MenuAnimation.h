@@ -0,0 +1,233 @@
+/**
+ * \file    MenuAnimation.h
+ * \brief   MenuAnimator, a non-blocking scheduler for menu transitions
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef MENU_ANIMATION_H
+#define MENU_ANIMATION_H
+
+#include "MenuSystem.h"
+
+#ifndef MENUSYSTEM_FRAME_INTERVAL
+//! The default minimum time between two frames, in the unit of the clock
+//! passed to MenuAnimator::update (usually milliseconds)
+#define MENUSYSTEM_FRAME_INTERVAL 20
+#endif
+
+//! \brief The progress of a transition when it's done
+//!
+//! Progress runs from 0 to MENU_PROGRESS_END so it fits in a byte and the
+//! primitives below need no floating point.
+#define MENU_PROGRESS_END 255
+
+//! \brief Easing curves for MenuTransition::easing
+enum MenuEasing {
+    EASE_LINEAR,
+    EASE_IN,     //!< starts slowly (quadratic)
+    EASE_OUT,    //!< ends slowly (quadratic)
+    EASE_IN_OUT  //!< starts and ends slowly
+};
+
+//! \brief Applies a MenuEasing to a progress
+//! \returns The eased progress, from 0 to MENU_PROGRESS_END.
+inline uint8_t menu_ease(uint8_t easing, uint8_t progress) {
+    uint16_t t = progress;
+    uint16_t r = MENU_PROGRESS_END - progress;
+    switch (easing) {
+    case EASE_IN:
+        return t * t / MENU_PROGRESS_END;
+    case EASE_OUT:
+        return MENU_PROGRESS_END - r * r / MENU_PROGRESS_END;
+    case EASE_IN_OUT:
+        if (t < 128)
+            return 2 * t * t / MENU_PROGRESS_END;
+        return MENU_PROGRESS_END - 2 * r * r / MENU_PROGRESS_END;
+    default:
+        return progress;
+    }
+}
+
+//! \brief Interpolates between from and to; the slide primitive
+//! \returns from at progress 0, to at MENU_PROGRESS_END.
+inline int16_t menu_lerp(int16_t from, int16_t to, uint8_t progress) {
+    return from + (int16_t) (((int32_t) to - from) * progress / MENU_PROGRESS_END);
+}
+
+//! \brief The fade primitive: fades out, then fades back in
+//!
+//! The transition shows its from state while menu_fade_shows_to returns
+//! false, then its to state.
+//!
+//! \returns The brightness, from max_level down to 0 at the half way point
+//!          and back up to max_level.
+inline uint8_t menu_fade_level(uint8_t max_level, uint8_t progress) {
+    uint8_t distance = progress < 128 ? 127 - progress : progress - 128;
+    return (uint16_t) max_level * distance / 127;
+}
+
+//! \see menu_fade_level
+inline bool menu_fade_shows_to(uint8_t progress) { return progress >= 128; }
+
+//! \brief A transition between two components
+struct MenuTransition {
+    enum Effect {
+        EFFECT_NONE,
+        EFFECT_SLIDE_UP,
+        EFFECT_SLIDE_DOWN,
+        EFFECT_SLIDE_LEFT,
+        EFFECT_SLIDE_RIGHT,
+        EFFECT_FADE
+    };
+
+    uint8_t effect;              //!< A MenuTransition::Effect
+    uint8_t easing;              //!< A MenuEasing
+    uint16_t duration;           //!< In the unit of the clock
+    MenuComponent const* p_from; //!< The component shown before
+    MenuComponent const* p_to;   //!< The component shown after
+};
+
+//! \brief Draws the frames of a MenuTransition; implemented by the renderer
+class MenuAnimationTarget {
+public:
+    //! \brief Draws transition at progress
+    //!
+    //! \param[in] transition The running transition.
+    //! \param[in] progress The eased progress; the last frame of every
+    //!                     transition is drawn with MENU_PROGRESS_END.
+    virtual void draw_transition(MenuTransition const& transition, uint8_t progress) const = 0;
+
+    virtual ~MenuAnimationTarget() {}
+};
+
+//! \brief Runs MenuTransitions one frame at a time
+//!
+//! The renderer starts a transition from MenuComponentRenderer::render and
+//! the main loop calls update() with the current time; each call draws at
+//! most one frame and returns, so input keeps being handled while the
+//! transition runs.
+//!
+//! A transition started while another one runs either interrupts it, which
+//! jumps the running transition to its last frame, or waits for it to
+//! finish. Waiting transitions are coalesced: only one is kept, going from
+//! the state the running transition ends in to the latest target.
+//!
+//! \code
+//! void render(Menu const& menu) const {
+//!     MenuTransition transition = { MenuTransition::EFFECT_FADE, EASE_IN_OUT, 300,
+//!                                   menu.get_menu_component(menu.get_previous_component_num()),
+//!                                   menu.get_current_component() };
+//!     animator.start(transition, millis());
+//! }
+//!
+//! void loop() {
+//!     handle_input();
+//!     animator.update(millis());
+//! }
+//! \endcode
+class MenuAnimator {
+public:
+    //! \param[in] target Draws the frames.
+    //! \param[in] frame_interval The minimum time between two frames.
+    MenuAnimator(MenuAnimationTarget const& target, uint16_t frame_interval=MENUSYSTEM_FRAME_INTERVAL)
+    : _target(target),
+    _start_time(0),
+    _frame_time(0),
+    _frame_interval(frame_interval),
+    _is_running(false),
+    _is_pending(false),
+    _interrupt(true) {
+    }
+
+    //! \brief Selects what happens to a running transition when another one
+    //!        starts
+    //!
+    //! \param[in] interrupt If true (the default) the running transition is
+    //!                      cut short; otherwise the new one waits.
+    void set_interrupt(bool interrupt) { _interrupt = interrupt; }
+
+    //! \brief Starts a transition, or queues it
+    //!
+    //! \param[in] transition The transition; copied.
+    //! \param[in] now The current time.
+    void start(MenuTransition const& transition, uint32_t now) {
+        if (_is_running && !_interrupt) {
+            if (_is_pending) {
+                _pending.effect = transition.effect;
+                _pending.easing = transition.easing;
+                _pending.duration = transition.duration;
+                _pending.p_to = transition.p_to;
+            } else {
+                _pending = transition;
+                _pending.p_from = _running.p_to;
+                _is_pending = true;
+            }
+            return;
+        }
+
+        if (_is_running)
+            _target.draw_transition(_running, MENU_PROGRESS_END);
+        _is_pending = false;
+        begin(transition, now);
+    }
+
+    //! \brief Draws the next frame if it's due
+    //!
+    //! \param[in] now The current time.
+    //! \returns true while a transition is running.
+    bool update(uint32_t now) {
+        if (!_is_running)
+            return false;
+        if (now - _frame_time < _frame_interval)
+            return true;
+        _frame_time = now;
+
+        uint32_t elapsed = now - _start_time;
+        if (elapsed < _running.duration) {
+            uint8_t progress = elapsed * MENU_PROGRESS_END / _running.duration;
+            _target.draw_transition(_running, menu_ease(_running.easing, progress));
+            return true;
+        }
+
+        _target.draw_transition(_running, MENU_PROGRESS_END);
+        _is_running = false;
+        if (_is_pending) {
+            _is_pending = false;
+            begin(_pending, now);
+        }
+        return _is_running;
+    }
+
+    //! \brief Jumps to the last frame and drops any waiting transition
+    void finish() {
+        if (_is_running)
+            _target.draw_transition(_running, MENU_PROGRESS_END);
+        _is_running = false;
+        _is_pending = false;
+    }
+
+    bool is_running() const { return _is_running; }
+
+private:
+    void begin(MenuTransition const& transition, uint32_t now) {
+        _running = transition;
+        _start_time = now;
+        // Draw the first frame on the next update()
+        _frame_time = now - _frame_interval;
+        _is_running = true;
+    }
+
+private:
+    MenuAnimationTarget const& _target;
+    MenuTransition _running;
+    MenuTransition _pending;
+    uint32_t _start_time;
+    uint32_t _frame_time;
+    uint16_t _frame_interval;
+    bool _is_running;
+    bool _is_pending;
+    bool _interrupt;
+};
+
+#endif // MENU_ANIMATION_H
@@ -0,0 +1,247 @@
+/**
+ * \file    MenuEventQueue.h
+ * \brief   MenuEventQueue, a lock-free queue of input events for a MenuSystem
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef MENU_EVENT_QUEUE_H
+#define MENU_EVENT_QUEUE_H
+
+#include "MenuSystem.h"
+#include "MenuAccelerator.h"
+
+#ifndef MENUSYSTEM_ATOMIC_LOAD
+#if defined(__GNUC__)
+//! Loads *p so that the writes made before the matching store are visible
+#define MENUSYSTEM_ATOMIC_LOAD(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+//! Stores v to *p after all the writes before it
+#define MENUSYSTEM_ATOMIC_STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#else
+#define MENUSYSTEM_ATOMIC_LOAD(p) (*(volatile uint8_t*) (p))
+#define MENUSYSTEM_ATOMIC_STORE(p, v) (*(volatile uint8_t*) (p) = (v))
+#endif
+#endif
+
+//! \brief An input event for a MenuSystem
+//!
+//! \see MenuEventQueue
+struct MenuEvent {
+    enum Type {
+        EVENT_NEXT,   //!< MenuSystem::next
+        EVENT_PREV,   //!< MenuSystem::prev
+        EVENT_SELECT, //!< MenuSystem::select
+        EVENT_BACK,   //!< MenuSystem::back
+        EVENT_RESET   //!< MenuSystem::reset
+    };
+
+    uint8_t type;  //!< A MenuEvent::Type
+    uint32_t time; //!< When the event happened, e.g. millis()
+};
+
+//! \brief A single-producer, single-consumer ring buffer of MenuEvents
+//!
+//! Input is recorded with push() where it happens, typically in an
+//! interrupt handler or an input thread, and applied to the MenuSystem with
+//! pump() from the main loop. Neither side blocks or disables interrupts:
+//! the producer only writes the head index and the consumer only writes the
+//! tail index, both single bytes. Events pushed while the queue is full are
+//! dropped and counted.
+//!
+//! \code
+//! MenuEventQueue<16> events;
+//!
+//! void on_encoder() { events.push(digitalRead(ENC_B) ? MenuEvent::EVENT_NEXT : MenuEvent::EVENT_PREV, millis()); }
+//!
+//! void loop() { events.pump(ms); }
+//! \endcode
+//!
+//! \tparam N The capacity; a power of two of at most 128.
+template <uint8_t N>
+class MenuEventQueue {
+    static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0,
+                  "MenuEventQueue capacity must be a power of two up to 128");
+public:
+    MenuEventQueue() : _head(0), _tail(0), _num_dropped(0) {}
+
+    //! \brief Appends an event; producer side
+    //!
+    //! \param[in] type A MenuEvent::Type.
+    //! \param[in] time When the event happened.
+    //! \returns true if the event was queued, false if the queue is full.
+    bool push(uint8_t type, uint32_t time=0) {
+        uint8_t head = _head;
+        if ((uint8_t) (head - MENUSYSTEM_ATOMIC_LOAD(&_tail)) == N) {
+            uint8_t num_dropped = _num_dropped;
+            if (num_dropped != UINT8_MAX)
+                MENUSYSTEM_ATOMIC_STORE(&_num_dropped, (uint8_t) (num_dropped + 1));
+            return false;
+        }
+
+        MenuEvent& event = _events[head & (N - 1)];
+        event.type = type;
+        event.time = time;
+        MENUSYSTEM_ATOMIC_STORE(&_head, (uint8_t) (head + 1));
+        return true;
+    }
+
+    //! \brief Removes the oldest event; consumer side
+    //!
+    //! \param[out] event The event.
+    //! \returns true if an event was removed, false if the queue is empty.
+    bool pop(MenuEvent& event) {
+        uint8_t tail = _tail;
+        if (MENUSYSTEM_ATOMIC_LOAD(&_head) == tail)
+            return false;
+
+        event = _events[tail & (N - 1)];
+        MENUSYSTEM_ATOMIC_STORE(&_tail, (uint8_t) (tail + 1));
+        return true;
+    }
+
+    //! \returns The number of events waiting.
+    uint8_t get_size() const {
+        return MENUSYSTEM_ATOMIC_LOAD(&_head) - MENUSYSTEM_ATOMIC_LOAD(&_tail);
+    }
+
+    bool is_empty() const { return get_size() == 0; }
+
+    //! \returns The number of events dropped because the queue was full,
+    //!          saturating at 255.
+    uint8_t get_num_dropped() const { return MENUSYSTEM_ATOMIC_LOAD(&_num_dropped); }
+
+    //! \brief Applies the waiting events to ms and renders once
+    //!
+    //! Runs of next events, and runs of prev events, are coalesced into a
+    //! single MenuSystem::move_by, so a fast encoder costs one transition per
+    //! run rather than one per detent. A change of direction ends the run:
+    //! next, next, prev moves by 2, then by -1, which matters at the ends of
+    //! a list when loop is false. Only the events present when pump() is
+    //! called are processed; events pushed meanwhile wait for the next call.
+    //! MenuSystem::display is called once if anything changed.
+    //!
+    //! With an accelerator, the next and prev events are scaled by their
+    //! speed, using MenuEvent::time, while the current component has focus.
+    //!
+    //! \param[in] ms The MenuSystem to drive.
+    //! \param[in] loop Passed on to MenuSystem::move_by.
+    //! \param[in] p_accelerator The accelerator, or nullptr.
+    //! \returns The number of events processed.
+    uint8_t pump(MenuSystem& ms, bool loop=false, MenuAccelerator* p_accelerator=nullptr) {
+        uint8_t num_events = get_size();
+        int32_t delta = 0;
+        MenuEvent event;
+
+        for (uint8_t i = 0; i < num_events && pop(event); ++i) {
+            if (event.type == MenuEvent::EVENT_NEXT || event.type == MenuEvent::EVENT_PREV) {
+                int8_t direction = event.type == MenuEvent::EVENT_NEXT ? 1 : -1;
+                if ((delta > 0 && direction < 0) || (delta < 0 && direction > 0)) {
+                    ms.move_by((int16_t) delta, loop);
+                    delta = 0;
+                    if (p_accelerator != nullptr)
+                        p_accelerator->reset();
+                }
+                if (p_accelerator != nullptr && is_focused(ms))
+                    delta += p_accelerator->accelerate(direction, event.time);
+                else
+                    delta += direction;
+                if (delta > INT16_MAX || delta < -INT16_MAX)
+                    delta = delta > 0 ? INT16_MAX : -INT16_MAX;
+                continue;
+            }
+
+            if (delta != 0) {
+                ms.move_by((int16_t) delta, loop);
+                delta = 0;
+            }
+            if (p_accelerator != nullptr)
+                p_accelerator->reset();
+            switch (event.type) {
+            case MenuEvent::EVENT_SELECT:
+                ms.select();
+                break;
+            case MenuEvent::EVENT_BACK:
+                ms.back();
+                break;
+            case MenuEvent::EVENT_RESET:
+                ms.reset();
+                break;
+            default:
+                break;
+            }
+        }
+        if (delta != 0)
+            ms.move_by((int16_t) delta, loop);
+
+        if (!ms.get_changes().is_empty())
+            ms.display();
+        return num_events;
+    }
+
+private:
+    static bool is_focused(MenuSystem const& ms) {
+        MenuComponent const* p_component = ms.get_current_menu()->get_current_component();
+        return p_component != nullptr && p_component->has_focus();
+    }
+
+private:
+    MenuEvent _events[N];
+    uint8_t _head;
+    uint8_t _tail;
+    uint8_t _num_dropped;
+};
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+
+static MenuComponent* ciut_queue_selected = nullptr;
+
+static void ciut_queue_on_select(MenuComponent* p_component) {
+    ciut_queue_selected = p_component;
+}
+
+TEST_CASE( .name="menu-event-queue", .description="Batched events of MenuEventQueue.", .skip=0 ) {
+    CiutNullRenderer renderer;
+    MenuSystem ms(renderer);
+    MenuItem mm_mi1("mm_mi1", &ciut_queue_on_select);
+    MenuItem mm_mi2("mm_mi2", &ciut_queue_on_select);
+    MenuItem mm_mi3("mm_mi3", &ciut_queue_on_select);
+    MenuItem mm_mi4("mm_mi4", &ciut_queue_on_select);
+    ms.get_root_menu().add_item(&mm_mi1);
+    ms.get_root_menu().add_item(&mm_mi2);
+    ms.get_root_menu().add_item(&mm_mi3);
+    ms.get_root_menu().add_item(&mm_mi4);
+    MenuEventQueue<8> events;
+
+    SECTION("a change of direction ends a run of moves") {
+        ms.end();
+        events.push(MenuEvent::EVENT_NEXT);
+        events.push(MenuEvent::EVENT_NEXT);
+        events.push(MenuEvent::EVENT_PREV);
+        REQUIRE(events.pump(ms) == 3);
+        REQUIRE(ms.get_current_menu()->get_current_component_num() == 2);
+
+        ms.home();
+        events.push(MenuEvent::EVENT_NEXT);
+        events.push(MenuEvent::EVENT_NEXT);
+        events.push(MenuEvent::EVENT_PREV);
+        REQUIRE(events.pump(ms) == 3);
+        REQUIRE(ms.get_current_menu()->get_current_component_num() == 1);
+    }
+
+    SECTION("moves are applied before a select of the same batch") {
+        ms.home();
+        ciut_queue_selected = nullptr;
+        events.push(MenuEvent::EVENT_NEXT);
+        events.push(MenuEvent::EVENT_NEXT);
+        events.push(MenuEvent::EVENT_SELECT);
+        events.push(MenuEvent::EVENT_NEXT);
+        REQUIRE(events.pump(ms) == 4);
+        REQUIRE(ciut_queue_selected == &mm_mi3);
+        REQUIRE(ms.get_current_menu()->get_current_component_num() == 3);
+        REQUIRE(events.is_empty());
+    }
+}
+
+#endif // CIUT_ENABLED
+
+#endif // MENU_EVENT_QUEUE_H
@@ -0,0 +1,504 @@
+/**
+ * \file    MenuHostLoop.h
+ * \brief   MenuHostLoop, an event loop that drives menus from file
+ *          descriptors and timers on POSIX hosts
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef MENU_HOST_LOOP_H
+#define MENU_HOST_LOOP_H
+
+#if !defined(ARDUINO)
+
+#include "MenuSystem.h"
+#include "MenuEventQueue.h"
+#include "MenuSession.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MENUSYSTEM_HOST_MAX_INPUTS
+//! \brief The number of inputs and outputs a MenuHostLoop serves
+#define MENUSYSTEM_HOST_MAX_INPUTS 16
+#endif
+
+#ifndef MENUSYSTEM_HOST_MAX_TIMERS
+//! \brief The number of timers of a MenuHostLoop
+#define MENUSYSTEM_HOST_MAX_TIMERS 8
+#endif
+
+//! \brief Turns the bytes of a terminal into MenuEvent::Types
+//!
+//! The arrow keys, as sent by ANSI terminals, and vi keys navigate:
+//! up and k are prev, down and j next, right, l, enter and space select,
+//! left, h and backspace go back. r resets the menu. Subclasses map other
+//! keys by overriding decode(); they get the bytes of escape sequences
+//! too.
+class MenuKeyDecoder {
+public:
+    //! Returned by decode() for bytes that aren't an event
+    static const int NO_EVENT = -1;
+
+    MenuKeyDecoder() : _escape(0) {}
+    virtual ~MenuKeyDecoder() {}
+
+    //! \brief Decodes the next byte of the input
+    //! \returns A MenuEvent::Type or NO_EVENT.
+    virtual int decode(uint8_t c) {
+        // ESC [ A to ESC [ D, or ESC O A... in application mode
+        if (_escape == 1) {
+            _escape = c == '[' || c == 'O' ? 2 : 0;
+            return NO_EVENT;
+        }
+        if (_escape == 2) {
+            _escape = 0;
+            switch (c) {
+            case 'A': return MenuEvent::EVENT_PREV;
+            case 'B': return MenuEvent::EVENT_NEXT;
+            case 'C': return MenuEvent::EVENT_SELECT;
+            case 'D': return MenuEvent::EVENT_BACK;
+            default: return NO_EVENT;
+            }
+        }
+
+        switch (c) {
+        case 0x1b: _escape = 1; return NO_EVENT;
+        case 'k': return MenuEvent::EVENT_PREV;
+        case 'j': return MenuEvent::EVENT_NEXT;
+        case 'l': case ' ': case '\r': case '\n': return MenuEvent::EVENT_SELECT;
+        case 'h': case 0x7f: case '\b': return MenuEvent::EVENT_BACK;
+        case 'r': return MenuEvent::EVENT_RESET;
+        default: return NO_EVENT;
+        }
+    }
+
+private:
+    uint8_t _escape;
+};
+
+//! \brief Drives MenuSystems and MenuSessions from file descriptors and
+//!        timers without busy waiting
+//!
+//! Each input is a file descriptor, e.g. stdin, a pty, a pipe or a socket,
+//! bound to a MenuSystem or to a MenuSession. The loop blocks in poll()
+//! until an input is readable or a timer is due, so an idle menu takes no
+//! CPU. The bytes read are decoded into MenuEvents, each run of next or
+//! of prev events of a read coalesced into one move_by, as
+//! MenuEventQueue::pump does. Then every menu with changes to show is displayed, once, and the
+//! loop blocks again.
+//!
+//! Any number of sessions of a MenuTree can be served from the one thread
+//! of the loop: when a session changes a value, the other sessions are
+//! displayed again too. Menus that take no input, e.g. a status display
+//! refreshed by a timer, are added with add_output(), and descriptors the
+//! application reads itself with add_reader().
+//!
+//! \code
+//! MenuHostLoop host;
+//!
+//! bool on_tick(void* p_context) {
+//!     uptime.set_value(MenuHostLoop::now_ms() / 1000);
+//!     ms.invalidate();
+//!     return true;
+//! }
+//!
+//! int main() {
+//!     build_menu();
+//!     host.add_input(STDIN_FILENO, ms);
+//!     host.add_timer(1000, &on_tick);
+//!     host.run();
+//! }
+//! \endcode
+//!
+//! poll() is used rather than epoll so the loop runs on any POSIX host; it
+//! serves up to MENUSYSTEM_HOST_MAX_INPUTS descriptors, where the linear
+//! scan costs nothing next to rendering.
+class MenuHostLoop {
+public:
+    //! \brief Called when a timer is due
+    //! \returns false to stop the timer.
+    using TimerFnPtr = bool (*)(void* p_context);
+
+    //! \brief Called when an input reached its end or failed
+    //!
+    //! The input is removed before the call; the callback may close fd.
+    using CloseFnPtr = void (*)(int fd, void* p_context);
+
+    //! \brief Called when a file descriptor added with add_reader is
+    //!        readable
+    //! \returns false to stop watching fd.
+    using ReadFnPtr = bool (*)(int fd, void* p_context);
+
+public:
+    MenuHostLoop() : _num_inputs(0), _num_timers(0), _running(false), _dispatching(false) {}
+
+    //! \brief Feeds the bytes read from fd to ms
+    //!
+    //! \param[in] fd A file descriptor; the loop doesn't close it.
+    //! \param[in] ms The menu the events go to.
+    //! \param[in] p_decoder The decoder; nullptr for a MenuKeyDecoder of
+    //!                      the input's own.
+    //! \param[in] on_close Called when fd reaches its end, or nullptr.
+    //! \param[in] p_context Passed to on_close.
+    //! \returns false if MENUSYSTEM_HOST_MAX_INPUTS inputs were added
+    //!          already.
+    bool add_input(int fd, MenuSystem& ms, MenuKeyDecoder* p_decoder=nullptr,
+                   CloseFnPtr on_close=nullptr, void* p_context=nullptr) {
+        return add(fd, &ms, nullptr, p_decoder, on_close, p_context, nullptr);
+    }
+
+    //! \brief Feeds the bytes read from fd to session
+    //! \copydetails add_input(int, MenuSystem&, MenuKeyDecoder*, CloseFnPtr, void*)
+    bool add_input(int fd, MenuSession& session, MenuKeyDecoder* p_decoder=nullptr,
+                   CloseFnPtr on_close=nullptr, void* p_context=nullptr) {
+        return add(fd, nullptr, &session, p_decoder, on_close, p_context, nullptr);
+    }
+
+    //! \brief Displays ms whenever it has changes, without reading input
+    bool add_output(MenuSystem& ms) { return add(-1, &ms, nullptr, nullptr, nullptr, nullptr, nullptr); }
+
+    //! \brief Displays session whenever it has changes, without reading input
+    bool add_output(MenuSession& session) { return add(-1, nullptr, &session, nullptr, nullptr, nullptr, nullptr); }
+
+    //! \brief Calls fn whenever fd is readable, for input that isn't a menu's
+    //!
+    //! fn reads from fd itself; if it doesn't, it's called again at once.
+    //! Menus changed by fn are displayed after it returns. fd is removed
+    //! with remove_input.
+    //!
+    //! \returns false if MENUSYSTEM_HOST_MAX_INPUTS inputs were added
+    //!          already.
+    bool add_reader(int fd, ReadFnPtr fn, void* p_context=nullptr) {
+        if (fd < 0 || fn == nullptr)
+            return false;
+        return add(fd, nullptr, nullptr, nullptr, nullptr, p_context, fn);
+    }
+
+    //! \brief Stops reading fd
+    //!
+    //! May be called from the callbacks of the loop, e.g. a select function
+    //! or a timer: the input is then only marked, and taken out of the
+    //! table when the pass over the inputs is done.
+    //!
+    //! \returns false if fd isn't an input.
+    bool remove_input(int fd) {
+        for (uint8_t i = 0; i < _num_inputs; ++i) {
+            if (_inputs[i].fd == fd && fd >= 0 && !_inputs[i].removed) {
+                _inputs[i].removed = true;
+                if (!_dispatching)
+                    compact_inputs();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! \brief Calls fn every interval_ms milliseconds
+    //!
+    //! Menus changed by fn, e.g. with MenuSystem::invalidate, are displayed
+    //! after it returns.
+    //!
+    //! \returns false if MENUSYSTEM_HOST_MAX_TIMERS timers run already.
+    bool add_timer(uint32_t interval_ms, TimerFnPtr fn, void* p_context=nullptr) {
+        if (_num_timers == MENUSYSTEM_HOST_MAX_TIMERS || fn == nullptr)
+            return false;
+        Timer& timer = _timers[_num_timers++];
+        timer.fn = fn;
+        timer.p_context = p_context;
+        timer.interval = interval_ms;
+        timer.due = now_ms() + interval_ms;
+        return true;
+    }
+
+    //! \brief Displays the menus with changes, waits for input or a timer
+    //!        and handles it
+    //!
+    //! \param[in] timeout_ms The longest wait, -1 for no limit.
+    //! \returns The number of inputs and timers handled, -1 if poll()
+    //!          failed.
+    int run_once(int timeout_ms=-1) {
+        // Inputs removed by the callbacks below stay in the table until the
+        // end, so the indices taken from it remain valid
+        _dispatching = true;
+        int num_handled = dispatch(timeout_ms);
+        _dispatching = false;
+        compact_inputs();
+        return num_handled;
+    }
+
+    //! \brief Runs until stop() is called or nothing is left to wait for
+    void run() {
+        _running = true;
+        while (_running && (has_inputs() || _num_timers != 0))
+            if (run_once() < 0)
+                break;
+        _running = false;
+    }
+
+    //! \brief Makes run() return, e.g. from a select function or a timer
+    void stop() { _running = false; }
+
+    //! \returns A monotonic time in milliseconds, as MenuEvent::time.
+    static uint32_t now_ms() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint32_t) ts.tv_sec * 1000 + (uint32_t) (ts.tv_nsec / 1000000);
+    }
+
+private:
+    struct Input {
+        int fd;
+        MenuSystem* p_ms;
+        MenuSession* p_session;
+        MenuKeyDecoder* p_decoder;  //!< nullptr for decoder
+        CloseFnPtr on_close;
+        ReadFnPtr on_read;  //!< set by add_reader, with no menu
+        void* p_context;
+        bool removed;  //!< by remove_input, while dispatching
+        //! The default decoder, one per input so the escape sequences of
+        //! one don't leak into another
+        MenuKeyDecoder decoder;
+
+        MenuKeyDecoder& get_decoder() { return p_decoder != nullptr ? *p_decoder : decoder; }
+    };
+
+    struct Timer {
+        TimerFnPtr fn;
+        void* p_context;
+        uint32_t interval;
+        uint32_t due;
+    };
+
+    int dispatch(int timeout_ms) {
+        display_changed();
+
+        struct pollfd fds[MENUSYSTEM_HOST_MAX_INPUTS];
+        uint8_t input_of[MENUSYSTEM_HOST_MAX_INPUTS];
+        nfds_t num_fds = 0;
+        for (uint8_t i = 0; i < _num_inputs; ++i) {
+            if (_inputs[i].fd < 0 || _inputs[i].removed)
+                continue;
+            fds[num_fds].fd = _inputs[i].fd;
+            fds[num_fds].events = POLLIN;
+            fds[num_fds].revents = 0;
+            input_of[num_fds++] = i;
+        }
+
+        int timeout = next_timeout();
+        if (timeout < 0 || (timeout_ms >= 0 && timeout_ms < timeout))
+            timeout = timeout_ms;
+
+        int num_ready = poll(fds, num_fds, timeout);
+        if (num_ready < 0)
+            return errno == EINTR ? 0 : -1;
+
+        int num_handled = 0;
+        for (nfds_t i = 0; i < num_fds; ++i) {
+            // Skips the inputs removed by the callbacks of the ones before
+            if (fds[i].revents == 0 || _inputs[input_of[i]].removed)
+                continue;
+            read_input(input_of[i]);
+            num_handled++;
+        }
+        num_handled += run_timers();
+        display_changed();
+        return num_handled;
+    }
+
+    bool add(int fd, MenuSystem* p_ms, MenuSession* p_session, MenuKeyDecoder* p_decoder,
+             CloseFnPtr on_close, void* p_context, ReadFnPtr on_read) {
+        if (_num_inputs == MENUSYSTEM_HOST_MAX_INPUTS)
+            return false;
+        Input& input = _inputs[_num_inputs++];
+        input.fd = fd;
+        input.p_ms = p_ms;
+        input.p_session = p_session;
+        input.p_decoder = p_decoder;
+        input.removed = false;
+        input.decoder = MenuKeyDecoder();
+        input.on_close = on_close;
+        input.on_read = on_read;
+        input.p_context = p_context;
+        return true;
+    }
+
+    bool has_inputs() const {
+        for (uint8_t i = 0; i < _num_inputs; ++i)
+            if (_inputs[i].fd >= 0 && !_inputs[i].removed)
+                return true;
+        return false;
+    }
+
+    //! Takes the inputs marked by remove_input out of the table
+    void compact_inputs() {
+        uint8_t num_left = 0;
+        for (uint8_t i = 0; i < _num_inputs; ++i)
+            if (!_inputs[i].removed)
+                _inputs[num_left++] = _inputs[i];
+        _num_inputs = num_left;
+    }
+
+    void read_input(uint8_t index) {
+        Input& input = _inputs[index];
+        if (input.on_read != nullptr) {
+            if (!input.on_read(input.fd, input.p_context))
+                input.removed = true;
+            return;
+        }
+
+        uint8_t buffer[64];
+        ssize_t size = read(input.fd, buffer, sizeof(buffer));
+        if (size < 0 && (errno == EINTR || errno == EAGAIN))
+            return;
+        if (size <= 0) {
+            input.removed = true;
+            if (input.on_close != nullptr)
+                input.on_close(input.fd, input.p_context);
+            return;
+        }
+
+        int32_t delta = 0;
+        for (ssize_t i = 0; i < size; ++i) {
+            int type = input.get_decoder().decode(buffer[i]);
+            if (type == MenuEvent::EVENT_NEXT || type == MenuEvent::EVENT_PREV) {
+                int8_t direction = type == MenuEvent::EVENT_NEXT ? 1 : -1;
+                // Only runs in one direction are coalesced, see
+                // MenuEventQueue::pump
+                if ((delta > 0 && direction < 0) || (delta < 0 && direction > 0)) {
+                    move_by(input, delta);
+                    delta = 0;
+                }
+                delta += direction;
+                continue;
+            }
+            if (type == MenuKeyDecoder::NO_EVENT)
+                continue;
+            move_by(input, delta);
+            delta = 0;
+            apply(input, (uint8_t) type);
+            // A select function may have removed the input
+            if (input.removed)
+                return;
+        }
+        move_by(input, delta);
+    }
+
+    static void move_by(Input const& input, int32_t delta) {
+        if (delta == 0)
+            return;
+        if (input.p_session != nullptr)
+            input.p_session->move_by((int16_t) delta);
+        else
+            input.p_ms->move_by((int16_t) delta);
+    }
+
+    static void apply(Input const& input, uint8_t type) {
+        if (input.p_session != nullptr) {
+            MenuSession& session = *input.p_session;
+            switch (type) {
+            case MenuEvent::EVENT_SELECT: session.select(); break;
+            case MenuEvent::EVENT_BACK: session.back(); break;
+            case MenuEvent::EVENT_RESET: session.reset(); break;
+            default: break;
+            }
+        } else {
+            MenuSystem& ms = *input.p_ms;
+            switch (type) {
+            case MenuEvent::EVENT_SELECT: ms.select(); break;
+            case MenuEvent::EVENT_BACK: ms.back(); break;
+            case MenuEvent::EVENT_RESET: ms.reset(); break;
+            default: break;
+            }
+        }
+    }
+
+    //! Displays the menus with changes, and the sessions another session
+    //! changed a value of
+    void display_changed() {
+        for (uint8_t i = 0; i < _num_inputs; ++i) {
+            Input& input = _inputs[i];
+            if (input.removed)
+                continue;
+            if (input.p_session != nullptr) {
+                if (!input.p_session->get_changes().is_empty() || input.p_session->is_stale())
+                    input.p_session->display();
+            } else if (input.p_ms != nullptr && !input.p_ms->get_changes().is_empty()) {
+                input.p_ms->display();
+            }
+        }
+    }
+
+    //! \returns The milliseconds until the next timer is due, -1 if none.
+    int next_timeout() const {
+        if (_num_timers == 0)
+            return -1;
+        uint32_t now = now_ms();
+        int32_t timeout = INT32_MAX;
+        for (uint8_t i = 0; i < _num_timers; ++i) {
+            int32_t left = (int32_t) (_timers[i].due - now);
+            if (left < timeout)
+                timeout = left;
+        }
+        return timeout > 0 ? (timeout < INT32_MAX ? (int) timeout : -1) : 0;
+    }
+
+    int run_timers() {
+        int num_run = 0;
+        uint32_t now = now_ms();
+        for (uint8_t i = _num_timers; i-- > 0;) {
+            Timer& timer = _timers[i];
+            if ((int32_t) (timer.due - now) > 0)
+                continue;
+            // Late timers skip the periods they missed rather than catch up
+            timer.due += timer.interval;
+            if ((int32_t) (timer.due - now) <= 0)
+                timer.due = now + timer.interval;
+            num_run++;
+            if (!timer.fn(timer.p_context))
+                _timers[i] = _timers[--_num_timers];
+        }
+        return num_run;
+    }
+
+private:
+    Input _inputs[MENUSYSTEM_HOST_MAX_INPUTS];
+    Timer _timers[MENUSYSTEM_HOST_MAX_TIMERS];
+    uint8_t _num_inputs;
+    uint8_t _num_timers;
+    bool _running;
+    bool _dispatching;
+};
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+
+TEST_CASE( .name="menu-host-loop", .description="Input read by MenuHostLoop.", .skip=0 ) {
+    CiutNullRenderer renderer;
+    MenuSystem ms(renderer);
+    MenuItem mm_mi1("mm_mi1", nullptr);
+    MenuItem mm_mi2("mm_mi2", nullptr);
+    MenuItem mm_mi3("mm_mi3", nullptr);
+    ms.get_root_menu().add_item(&mm_mi1);
+    ms.get_root_menu().add_item(&mm_mi2);
+    ms.get_root_menu().add_item(&mm_mi3);
+
+    SECTION("a run of moves stops at the end of the menu before turning back") {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        MenuHostLoop host;
+        REQUIRE(host.add_input(fds[0], ms));
+        REQUIRE(write(fds[1], "jjjjk", 5) == 5);
+        REQUIRE(host.run_once(0) == 1);
+        REQUIRE(ms.get_current_menu()->get_current_component_num() == 1);
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
+
+#endif // CIUT_ENABLED
+
+#endif // !ARDUINO
+
+#endif // MENU_HOST_LOOP_H
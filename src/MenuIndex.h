@@ -0,0 +1,253 @@
+/**
+ * \file    MenuIndex.h
+ * \brief   MenuIndex, finds components by path to jump straight to them
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef MENU_INDEX_H
+#define MENU_INDEX_H
+
+#include "MenuSystem.h"
+
+#ifndef MENUSYSTEM_PATH_SEPARATOR
+//! The character between the names of a path
+#define MENUSYSTEM_PATH_SEPARATOR '/'
+#endif
+
+//! \brief An index of the components of a tree by path
+//!
+//! The index is built once from a complete tree. Each component gets an ID,
+//! its position in a depth first walk of the tree, which stays the same as
+//! long as the tree does, and is found by its path, the names from the root
+//! menu down separated by MENUSYSTEM_PATH_SEPARATOR, with a hash table in
+//! O(length of the path). jump() then moves the MenuSystem straight to the
+//! component, see MenuSystem::jump_to, instead of replaying next() and
+//! select() calls.
+//!
+//! The name of the root menu isn't part of the paths. If siblings share a
+//! name, the path finds the first of them. Components whose name changes,
+//! such as the slots of a DataSourceMenu, can't be found by name; build the
+//! index again after the tree changed.
+//!
+//! \code
+//! StaticMenuIndex<32> index;
+//!
+//! void setup() {
+//!     build_menu();
+//!     index.build(ms.get_root_menu());
+//! }
+//!
+//! void on_command(const char* path) {
+//!     if (index.jump(ms, path))  // e.g. "Settings/Display/Brightness"
+//!         ms.display();
+//! }
+//! \endcode
+//!
+//! \see StaticMenuIndex
+class MenuIndex {
+public:
+    //! The ID returned when nothing was found
+    static const uint16_t NO_ENTRY = 0xffff;
+
+    //! \brief Indexes the components below root
+    //!
+    //! \returns true on success, false if the tree has more components than
+    //!          the index holds; the index is then empty.
+    bool build(Menu const& root) {
+        _num_entries = 0;
+        for (uint16_t i = 0; i < _num_slots; ++i)
+            _p_slots[i] = NO_ENTRY;
+
+        if (!add_components(root, NO_ENTRY, FNV_OFFSET_BASIS)) {
+            _num_entries = 0;
+            for (uint16_t i = 0; i < _num_slots; ++i)
+                _p_slots[i] = NO_ENTRY;
+            return false;
+        }
+        return true;
+    }
+
+    //! \returns The number of components indexed.
+    uint16_t get_num_entries() const { return _num_entries; }
+
+    //! \brief Finds a component by path
+    //! \returns The ID of the component or NO_ENTRY.
+    uint16_t find(const char* path) const {
+        size_t length = strlen(path);
+        uint32_t hash = FNV_OFFSET_BASIS;
+        for (size_t i = 0; i < length; ++i)
+            hash = hash_byte(hash, path[i]);
+
+        for (uint16_t slot = first_slot(hash); _p_slots[slot] != NO_ENTRY;
+             slot = (slot + 1) & (_num_slots - 1)) {
+            uint16_t id = _p_slots[slot];
+            if (_p_entries[id].hash == hash && matches(id, path, length))
+                return id;
+        }
+        return NO_ENTRY;
+    }
+
+    //! \returns The component with ID id, nullptr if there's none.
+    MenuComponent const* get_component(uint16_t id) const {
+        return id < _num_entries ? _p_entries[id].p_component : nullptr;
+    }
+
+    //! \returns The ID of the menu holding the component with ID id,
+    //!          NO_ENTRY for components of the root menu.
+    uint16_t get_parent(uint16_t id) const {
+        return id < _num_entries ? _p_entries[id].parent : NO_ENTRY;
+    }
+
+    //! \brief Writes the indices from the root menu to a component
+    //!
+    //! \param[in] id The ID of the component.
+    //! \param[out] indices Receives the indices, as MenuSystem::jump_to
+    //!                     takes them.
+    //! \param[in] size The number of elements of indices.
+    //! \returns The number of indices; 0 if id is invalid or the component is
+    //!          deeper than size.
+    uint8_t get_indices(uint16_t id, menu_index_t* indices, uint8_t size) const {
+        if (id >= _num_entries)
+            return 0;
+
+        uint8_t length = 0;
+        for (uint16_t i = id; i != NO_ENTRY; i = _p_entries[i].parent)
+            ++length;
+        if (length > size)
+            return 0;
+
+        uint8_t i = length;
+        for (; id != NO_ENTRY; id = _p_entries[id].parent)
+            indices[--i] = _p_entries[id].index;
+        return length;
+    }
+
+    //! \brief Makes the component with ID id the current component of ms
+    //! \returns false if id is invalid, the component is deeper than
+    //!          MENUSYSTEM_MAX_DEPTH or MenuSystem::jump_to failed.
+    bool jump(MenuSystem& ms, uint16_t id) const {
+        menu_index_t indices[MENUSYSTEM_MAX_DEPTH];
+        uint8_t length = get_indices(id, indices, MENUSYSTEM_MAX_DEPTH);
+        return length != 0 && ms.jump_to(indices, length);
+    }
+
+    //! \brief Makes the component at path the current component of ms
+    bool jump(MenuSystem& ms, const char* path) const { return jump(ms, find(path)); }
+
+protected:
+    //! \brief An indexed component
+    struct Entry {
+        MenuComponent const* p_component;
+        uint32_t hash;        //!< of the path
+        uint16_t parent;      //!< the ID of the parent menu
+        menu_index_t index;   //!< in the parent menu
+    };
+
+    //! \param[in] p_entries An array of capacity entries.
+    //! \param[in] p_slots The hash table; a power of two larger than capacity.
+    MenuIndex(Entry* p_entries, uint16_t capacity, uint16_t* p_slots, uint16_t num_slots)
+    : _p_entries(p_entries),
+    _p_slots(p_slots),
+    _capacity(capacity),
+    _num_slots(num_slots),
+    _num_entries(0) {
+        for (uint16_t i = 0; i < _num_slots; ++i)
+            _p_slots[i] = NO_ENTRY;
+    }
+
+private:
+    static const uint32_t FNV_OFFSET_BASIS = 0x811c9dc5UL;
+
+    static uint32_t hash_byte(uint32_t hash, char c) {
+        return (hash ^ (uint8_t) c) * 16777619UL;
+    }
+
+    uint16_t first_slot(uint32_t hash) const {
+        return (uint16_t) (hash ^ (hash >> 16)) & (_num_slots - 1);
+    }
+
+    bool add_components(Menu const& menu, uint16_t parent, uint32_t parent_hash) {
+        for (menu_index_t i = 0; i < menu.get_num_components(); ++i) {
+            if (_num_entries == _capacity)
+                return false;
+
+            MenuComponent const* p_component = menu.get_menu_component(i);
+            uint32_t hash = parent_hash;
+            if (parent != NO_ENTRY)
+                hash = hash_byte(hash, MENUSYSTEM_PATH_SEPARATOR);
+            for (const char* p = p_component->get_name(); *p != '\0'; ++p)
+                hash = hash_byte(hash, *p);
+
+            uint16_t id = _num_entries++;
+            Entry& entry = _p_entries[id];
+            entry.p_component = p_component;
+            entry.hash = hash;
+            entry.parent = parent;
+            entry.index = i;
+
+            // Keep the first of two equal paths
+            uint16_t slot = first_slot(hash);
+            while (_p_slots[slot] != NO_ENTRY)
+                slot = (slot + 1) & (_num_slots - 1);
+            _p_slots[slot] = id;
+
+            if (p_component->get_type() == MenuComponent::TYPE_MENU
+                && !add_components(static_cast<Menu const&>(*p_component), id, hash))
+                return false;
+        }
+        return true;
+    }
+
+    //! Compares the path of id with the first length characters of path
+    bool matches(uint16_t id, const char* path, size_t length) const {
+        for (;;) {
+            const char* name = _p_entries[id].p_component->get_name();
+            size_t name_length = strlen(name);
+            if (name_length > length
+                || memcmp(path + length - name_length, name, name_length) != 0)
+                return false;
+            length -= name_length;
+
+            id = _p_entries[id].parent;
+            if (id == NO_ENTRY)
+                return length == 0;
+            if (length == 0 || path[length - 1] != MENUSYSTEM_PATH_SEPARATOR)
+                return false;
+            --length;
+        }
+    }
+
+private:
+    Entry* _p_entries;
+    uint16_t* _p_slots;
+    uint16_t _capacity;
+    uint16_t _num_slots;
+    uint16_t _num_entries;
+};
+
+//! \brief A MenuIndex for up to N components, stored inline
+//!
+//! \tparam N The maximum number of components; at most 16384.
+//!
+//! \see MenuIndex
+template <uint16_t N>
+class StaticMenuIndex : public MenuIndex {
+    static_assert(N > 0 && N <= 0x4000, "StaticMenuIndex holds 1 to 16384 components");
+public:
+    StaticMenuIndex() : MenuIndex(_entries, N, _slots, NUM_SLOTS) {}
+
+private:
+    //! The smallest power of two larger than n
+    static constexpr uint16_t slots_for(uint16_t n, uint16_t slots=1) {
+        return slots > n ? slots : slots_for(n, slots * 2);
+    }
+
+    // The table is at most half full so probes stay short
+    static const uint16_t NUM_SLOTS = slots_for(2 * N - 1);
+
+    Entry _entries[N];
+    uint16_t _slots[NUM_SLOTS];
+};
+
+#endif // MENU_INDEX_H
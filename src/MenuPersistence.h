@@ -0,0 +1,464 @@
+/**
+ * \file    MenuPersistence.h
+ * \brief   MenuPersistence, saves and restores the state of a menu tree
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef MENU_PERSISTENCE_H
+#define MENU_PERSISTENCE_H
+
+#include "MenuSystem.h"
+
+#if !defined(ARDUINO)
+#include <stdio.h>
+#endif
+
+#ifndef MENUSYSTEM_MAX_STATE_SIZE
+//! The largest state of a single component, in bytes; larger states, e.g.
+//! long TextEditMenuItem buffers, are truncated
+#define MENUSYSTEM_MAX_STATE_SIZE 32
+#endif
+
+//! \brief Where MenuPersistence keeps its data: EEPROM, flash, a file...
+//!
+//! \code
+//! class EepromStorage : public MenuStorage {
+//! public:
+//!     bool read(uint16_t address, uint8_t* data, uint16_t size) {
+//!         for (uint16_t i = 0; i < size; ++i)
+//!             data[i] = EEPROM.read(address + i);
+//!         return address + size <= EEPROM.length();
+//!     }
+//!     bool write(uint16_t address, const uint8_t* data, uint16_t size) {
+//!         for (uint16_t i = 0; i < size; ++i)
+//!             EEPROM.write(address + i, data[i]);
+//!         return address + size <= EEPROM.length();
+//!     }
+//! };
+//! \endcode
+class MenuStorage {
+public:
+    //! \returns true if size bytes were read at address.
+    virtual bool read(uint16_t address, uint8_t* data, uint16_t size) = 0;
+
+    //! \returns true if size bytes were written at address.
+    virtual bool write(uint16_t address, const uint8_t* data, uint16_t size) = 0;
+
+    //! \brief Makes the writes durable, e.g. EEPROM.commit() on ESP boards
+    virtual bool commit() { return true; }
+
+    virtual ~MenuStorage() {}
+};
+
+#if !defined(ARDUINO)
+//! \brief A MenuStorage in a file, for host builds
+class MenuFileStorage : public MenuStorage {
+public:
+    //! \brief Opens path, creating it if needed
+    explicit MenuFileStorage(const char* path) : _p_file(fopen(path, "r+b")) {
+        if (_p_file == nullptr)
+            _p_file = fopen(path, "w+b");
+    }
+
+    ~MenuFileStorage() {
+        if (_p_file != nullptr)
+            fclose(_p_file);
+    }
+
+    bool is_open() const { return _p_file != nullptr; }
+
+    bool read(uint16_t address, uint8_t* data, uint16_t size) {
+        return _p_file != nullptr && fseek(_p_file, address, SEEK_SET) == 0
+            && fread(data, 1, size, _p_file) == size;
+    }
+
+    bool write(uint16_t address, const uint8_t* data, uint16_t size) {
+        return _p_file != nullptr && fseek(_p_file, address, SEEK_SET) == 0
+            && fwrite(data, 1, size, _p_file) == size;
+    }
+
+    bool commit() { return _p_file != nullptr && fflush(_p_file) == 0; }
+
+private:
+    MenuFileStorage(MenuFileStorage const&);
+    MenuFileStorage& operator=(MenuFileStorage const&);
+
+    FILE* _p_file;
+};
+#endif
+
+//! \brief Saves the state of a menu tree to a MenuStorage and restores it
+//!
+//! The tree is walked depth first and every component whose
+//! MenuComponent::save_state returns data gets a record: its key, the size
+//! of its state and the state. The key is a 16 bit FNV-1a hash of the names
+//! on the path from the root, so it stays the same when unrelated components
+//! are added elsewhere; components with state need a unique path.
+//!
+//! The blob starts with a header:
+//!
+//! | bytes | content                              |
+//! |-------|--------------------------------------|
+//! | 2     | 'M', 'S'                             |
+//! | 1     | format version                       |
+//! | 1     | schema version, set by the client    |
+//! | 2     | size of the records, little endian   |
+//! | 2     | Fletcher-16 checksum of the records  |
+//!
+//! followed by the records, each a 2 byte key, a 1 byte size and the state.
+//!
+//! The size of a record never depends on the state, so every record has a
+//! fixed address. save() compares each byte with what's stored and only
+//! writes the bytes that changed, which saves EEPROM wear and time: saving
+//! after a single value changed typically writes that value and the
+//! checksum. load() checks the header and the checksum, then restores every
+//! record in a single walk of the tree.
+//!
+//! Bump the schema version when the menu tree changes in a way that keys
+//! don't capture; load() then keeps the defaults.
+//!
+//! \code
+//! EepromStorage storage;
+//! MenuPersistence persistence(storage);
+//!
+//! void setup() {
+//!     build_menu();
+//!     persistence.load(ms.get_root_menu());
+//! }
+//!
+//! void on_value_changed(MenuComponent* p_menu_component) {
+//!     persistence.save(ms.get_root_menu());
+//! }
+//! \endcode
+class MenuPersistence {
+public:
+    //! The version of the blob format
+    static const uint8_t FORMAT_VERSION = 1;
+    //! The size of the header
+    static const uint8_t HEADER_SIZE = 8;
+
+    //! \param[in] storage The storage; must outlive the MenuPersistence.
+    //! \param[in] address Where the blob starts in storage.
+    //! \param[in] schema_version The version of the menu tree.
+    MenuPersistence(MenuStorage& storage, uint16_t address=0, uint8_t schema_version=0)
+    : _storage(storage),
+    _address(address),
+    _schema_version(schema_version),
+    _num_written(0) {
+    }
+
+    //! \brief Writes the state of root and its descendants
+    //!
+    //! \returns true on success, false if the storage failed.
+    bool save(Menu const& root) {
+        Walk walk(WALK_SAVE, _address + HEADER_SIZE);
+        _num_written = 0;
+        if (!save_records(root, key_of(ROOT_KEY, root), walk))
+            return false;
+
+        uint8_t header[HEADER_SIZE];
+        make_header(header, walk.address - _address - HEADER_SIZE, walk.checksum());
+        if (!update(_address, header, HEADER_SIZE))
+            return false;
+        return _num_written == 0 || _storage.commit();
+    }
+
+    //! \brief Restores the state of root and its descendants
+    //!
+    //! Nothing is restored if the blob is missing, was written by another
+    //! format or schema version, or is corrupt. A record whose key or size
+    //! doesn't match the tree stops the load; the remaining components keep
+    //! their state. States rejected by MenuComponent::load_state are skipped.
+    //!
+    //! Call it before the first MenuSystem::display, or call
+    //! MenuSystem::invalidate afterwards.
+    //!
+    //! \returns true if every record was restored.
+    bool load(Menu& root) {
+        uint8_t header[HEADER_SIZE];
+        if (!_storage.read(_address, header, HEADER_SIZE))
+            return false;
+        if (header[0] != 'M' || header[1] != 'S' || header[2] != FORMAT_VERSION
+            || header[3] != _schema_version)
+            return false;
+
+        uint16_t size = header[4] | (header[5] << 8);
+        uint16_t checksum = header[6] | (header[7] << 8);
+        if (!check(_address + HEADER_SIZE, size, checksum))
+            return false;
+
+        Walk walk(WALK_LOAD, _address + HEADER_SIZE);
+        walk.end = walk.address + size;
+        return load_records(root, key_of(ROOT_KEY, root), walk)
+            && walk.address == walk.end;
+    }
+
+    //! \returns The size of the blob for root, to reserve storage.
+    uint16_t get_size(Menu const& root) const {
+        Walk walk(WALK_SIZE, 0);
+        const_cast<MenuPersistence*>(this)->save_records(root, 0, walk);
+        return HEADER_SIZE + walk.address;
+    }
+
+    //! \returns The number of bytes the last save() wrote.
+    uint16_t get_num_written() const { return _num_written; }
+
+private:
+    static const uint32_t FNV_OFFSET_BASIS = 0x811c9dc5UL;
+    static const uint32_t FNV_PRIME = 16777619UL;
+    //! The parent key of the root menu: FNV_OFFSET_BASIS folded to 16 bits
+    //! the way key_of folds its hash
+    static const uint16_t ROOT_KEY = (uint16_t) (FNV_OFFSET_BASIS ^ (FNV_OFFSET_BASIS >> 16));
+
+    enum WalkMode { WALK_SIZE, WALK_SAVE, WALK_LOAD };
+
+    struct Walk {
+        Walk(uint8_t mode, uint16_t address)
+        : mode(mode), address(address), end(0), sum1(0), sum2(0) {}
+
+        void add(const uint8_t* data, uint16_t size) {
+            for (uint16_t i = 0; i < size; ++i) {
+                sum1 = (sum1 + data[i]) % 255;
+                sum2 = (sum2 + sum1) % 255;
+            }
+        }
+
+        uint16_t checksum() const { return (sum2 << 8) | sum1; }
+
+        uint8_t mode;
+        uint16_t address;
+        uint16_t end;
+        uint16_t sum1;
+        uint16_t sum2;
+    };
+
+    //! \brief The key of component below the component keyed parent_key
+    //!
+    //! The 32 bit FNV-1a hash of the name, with parent_key mixed into the
+    //! offset basis, folded to 16 bits by xoring its halves.
+    static uint16_t key_of(uint16_t parent_key, MenuComponent const& component) {
+        uint32_t hash = FNV_OFFSET_BASIS ^ parent_key;
+        for (const char* p = component.get_name(); *p != '\0'; ++p) {
+            hash ^= (uint8_t) *p;
+            hash *= FNV_PRIME;
+        }
+        return (uint16_t) (hash ^ (hash >> 16));
+    }
+
+    static bool is_menu(MenuComponent const& component) {
+        return component.get_type() == MenuComponent::TYPE_MENU;
+    }
+
+    bool save_records(Menu const& menu, uint16_t key, Walk& walk) {
+        if (!save_record(menu, key, walk))
+            return false;
+        for (menu_index_t i = 0; i < menu.get_num_components(); ++i) {
+            MenuComponent const& component = *menu.get_menu_component(i);
+            uint16_t child_key = key_of(key, component);
+            bool saved = is_menu(component)
+                ? save_records(static_cast<Menu const&>(component), child_key, walk)
+                : save_record(component, child_key, walk);
+            if (!saved)
+                return false;
+        }
+        return true;
+    }
+
+    bool save_record(MenuComponent const& component, uint16_t key, Walk& walk) {
+        uint8_t record[3 + MENUSYSTEM_MAX_STATE_SIZE];
+        uint8_t size = component.save_state(record + 3, MENUSYSTEM_MAX_STATE_SIZE);
+        if (size == 0)
+            return true;
+
+        record[0] = key & 0xff;
+        record[1] = key >> 8;
+        record[2] = size;
+        if (walk.mode == WALK_SAVE && !update(walk.address, record, 3 + size))
+            return false;
+        walk.add(record, 3 + size);
+        walk.address += 3 + size;
+        return true;
+    }
+
+    bool load_records(Menu& menu, uint16_t key, Walk& walk) {
+        // Restore the children first: the cursor of a menu is checked
+        // against its components
+        uint16_t menu_address = walk.address;
+        if (!skip_record(menu, walk))
+            return false;
+
+        for (menu_index_t i = 0; i < menu.get_num_components(); ++i) {
+            MenuComponent& component = const_cast<MenuComponent&>(*menu.get_menu_component(i));
+            uint16_t child_key = key_of(key, component);
+            bool loaded = is_menu(component)
+                ? load_records(static_cast<Menu&>(component), child_key, walk)
+                : load_record(component, child_key, walk);
+            if (!loaded)
+                return false;
+        }
+
+        uint16_t end_address = walk.address;
+        walk.address = menu_address;
+        bool loaded = load_record(menu, key, walk);
+        walk.address = end_address;
+        return loaded;
+    }
+
+    //! Skips the record of component, if it has one
+    bool skip_record(MenuComponent const& component, Walk& walk) {
+        uint8_t state[MENUSYSTEM_MAX_STATE_SIZE];
+        uint8_t size = component.save_state(state, sizeof(state));
+        if (size != 0)
+            walk.address += 3 + size;
+        return walk.address <= walk.end;
+    }
+
+    bool load_record(MenuComponent& component, uint16_t key, Walk& walk) {
+        uint8_t record[3 + MENUSYSTEM_MAX_STATE_SIZE];
+        uint8_t size = component.save_state(record, MENUSYSTEM_MAX_STATE_SIZE);
+        if (size == 0)
+            return true;
+
+        if (walk.address + 3 + size > walk.end
+            || !_storage.read(walk.address, record, 3 + size))
+            return false;
+        if (record[0] != (key & 0xff) || record[1] != (key >> 8) || record[2] != size)
+            return false;
+
+        component.load_state(record + 3, size);
+        walk.address += 3 + size;
+        return true;
+    }
+
+    void make_header(uint8_t* header, uint16_t size, uint16_t checksum) const {
+        header[0] = 'M';
+        header[1] = 'S';
+        header[2] = FORMAT_VERSION;
+        header[3] = _schema_version;
+        header[4] = size & 0xff;
+        header[5] = size >> 8;
+        header[6] = checksum & 0xff;
+        header[7] = checksum >> 8;
+    }
+
+    //! Verifies the checksum of the records before anything is restored
+    bool check(uint16_t address, uint16_t size, uint16_t checksum) {
+        Walk walk(WALK_LOAD, address);
+        uint8_t buffer[16];
+        while (size > 0) {
+            uint16_t n = size < sizeof(buffer) ? size : sizeof(buffer);
+            if (!_storage.read(address, buffer, n))
+                return false;
+            walk.add(buffer, n);
+            address += n;
+            size -= n;
+        }
+        return walk.checksum() == checksum;
+    }
+
+    //! Writes the bytes of data that differ from the stored ones
+    bool update(uint16_t address, const uint8_t* data, uint16_t size) {
+        uint8_t stored[3 + MENUSYSTEM_MAX_STATE_SIZE];
+        if (!_storage.read(address, stored, size)) {
+            // Past the end of a new file, or unreadable: write it all
+            _num_written += size;
+            return _storage.write(address, data, size);
+        }
+
+        uint16_t i = 0;
+        while (i < size) {
+            if (stored[i] == data[i]) {
+                ++i;
+                continue;
+            }
+            uint16_t start = i;
+            while (i < size && stored[i] != data[i])
+                ++i;
+            _num_written += i - start;
+            if (!_storage.write(address + start, data + start, i - start))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    MenuStorage& _storage;
+    uint16_t _address;
+    uint8_t _schema_version;
+    uint16_t _num_written;
+};
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+
+//! A MenuStorage in RAM, counting the bytes written to it
+class CiutRamStorage : public MenuStorage {
+public:
+    CiutRamStorage() : num_written(0) { memset(data, 0xff, sizeof(data)); }
+
+    bool read(uint16_t address, uint8_t* buffer, uint16_t size) {
+        if (address + size > sizeof(data))
+            return false;
+        memcpy(buffer, data + address, size);
+        return true;
+    }
+
+    bool write(uint16_t address, const uint8_t* buffer, uint16_t size) {
+        if (address + size > sizeof(data))
+            return false;
+        memcpy(data + address, buffer, size);
+        num_written += size;
+        return true;
+    }
+
+    uint8_t data[64];
+    uint16_t num_written;
+};
+
+TEST_CASE( .name="menu-persistence", .description="Saving and loading with MenuPersistence.", .skip=0 ) {
+    CiutNullRenderer renderer;
+    MenuSystem ms(renderer);
+    Menu mu1("mu1");
+    NumericMenuItem mu1_mi1("mu1_mi1", nullptr, 1.0, 0.0, 10.0, 0.1);
+    NumericMenuItem mu1_mi2("mu1_mi2", nullptr, 5.0, 0.0, 10.0);
+    MenuItem mm_mi1("mm_mi1", nullptr);
+    ms.get_root_menu().add_menu(&mu1);
+    ms.get_root_menu().add_item(&mm_mi1);
+    mu1.add_item(&mu1_mi1);
+    mu1.add_item(&mu1_mi2);
+    CiutRamStorage storage;
+    MenuPersistence persistence(storage);
+
+    SECTION("load restores what save wrote") {
+        mu1_mi1.set_value(1.0);
+        mu1_mi2.set_value(5.0);
+        REQUIRE(persistence.save(ms.get_root_menu()));
+        REQUIRE(storage.num_written == persistence.get_size(ms.get_root_menu()));
+
+        mu1_mi1.set_value(2.0);
+        mu1_mi2.set_value(7.0);
+        REQUIRE(persistence.load(ms.get_root_menu()));
+        REQUIRE(mu1_mi1.get_value() == 1.0);
+        REQUIRE(mu1_mi2.get_value() == 5.0);
+    }
+
+    SECTION("save only writes the bytes that changed") {
+        mu1_mi1.set_value(1.0);
+        mu1_mi2.set_value(5.0);
+        REQUIRE(persistence.save(ms.get_root_menu()));
+
+        REQUIRE(persistence.save(ms.get_root_menu()));
+        REQUIRE(persistence.get_num_written() == 0);
+
+        // 1.0 and 1.1 differ in three bytes, plus the two checksum bytes
+        storage.num_written = 0;
+        mu1_mi1.set_value(1.1f);
+        REQUIRE(persistence.save(ms.get_root_menu()));
+        REQUIRE(persistence.get_num_written() == 5);
+        REQUIRE(storage.num_written == 5);
+    }
+}
+
+#endif // CIUT_ENABLED
+
+#endif // MENU_PERSISTENCE_H
@@ -0,0 +1,171 @@
+/**
+ * \file    MenuSession.h
+ * \brief   MenuSession, one of several users navigating a shared menu tree
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef MENU_SESSION_H
+#define MENU_SESSION_H
+
+#include "MenuSystem.h"
+
+class MenuSession;
+
+//! \brief A menu tree shared by several MenuSessions
+//!
+//! The tree keeps the cursor of one session at a time: the session that
+//! was used last. A session that is used while another one holds the tree
+//! swaps the cursors in O(1), see MenuSystem::save_cursor. The tree itself
+//! is never copied, so the values of the items are shared: a setting
+//! changed in one session is changed for all of them, and the other
+//! sessions redraw it the next time they are used.
+//!
+//! The sessions of a tree must be used from one thread, e.g. an event
+//! loop serving all of them, or under a lock held across
+//! MenuSession::attach and the use of the MenuSystem it returns.
+//!
+//! \see MenuSession
+class MenuTree {
+    friend class MenuSession;
+public:
+    //! \param[in] root_menu The root menu of the tree; must outlive the
+    //!                      MenuTree.
+    explicit MenuTree(Menu& root_menu) : _root_menu(root_menu), _p_attached(nullptr), _version(0) {}
+
+    Menu& get_root_menu() const { return _root_menu; }
+
+    //! \returns The session whose cursor is in the tree, nullptr if none.
+    MenuSession const* get_attached() const { return _p_attached; }
+
+    //! \returns A number that changes whenever a session changes a value.
+    uint16_t get_version() const { return _version; }
+
+    //! \brief Records that a value was changed outside of the sessions
+    //!
+    //! E.g. by a sensor reading; every session displays it again.
+    void invalidate() { ++_version; }
+
+private:
+    Menu& _root_menu;
+    MenuSession* _p_attached;
+    uint16_t _version;
+};
+
+//! \brief A user of a MenuTree with a cursor and a renderer of its own
+//!
+//! Each session is a MenuSystem on the root menu of the tree plus the
+//! MenuCursor it leaves behind when another session takes the tree. The
+//! navigation functions of the session attach it to the tree first; for
+//! the other functions of the MenuSystem, call attach() and use the
+//! MenuSystem it returns.
+//!
+//! Back items in a shared tree must be built without a MenuSystem, e.g.
+//! BackMenuItem("Back", nullptr, nullptr), so they go back in the session
+//! that selects them.
+//!
+//! \code
+//! MenuTree tree(root_menu);
+//! MenuSession lcd(tree, lcd_renderer);
+//! MenuSession console(tree, console_renderer);
+//!
+//! void on_lcd_button() {
+//!     lcd.next();
+//!     lcd.display();
+//! }
+//!
+//! void on_console_char(char c) {
+//!     if (c == 'f')
+//!         console.attach().filter_add_char('a');
+//!     console.display();
+//! }
+//! \endcode
+//!
+//! \see MenuTree
+class MenuSession {
+public:
+    //! \param[in] tree The tree the session navigates.
+    //! \param[in] renderer The renderer of the session.
+    MenuSession(MenuTree& tree, MenuComponentRenderer const& renderer)
+    : _ms(renderer, tree._root_menu),
+    _tree(tree),
+    _cursor(),  // on the first component of the root menu
+    _version(tree._version) {
+    }
+
+    ~MenuSession() {
+        if (_tree._p_attached == this)
+            _tree._p_attached = nullptr;
+    }
+
+    //! \brief Puts the cursor of this session into the tree
+    //!
+    //! Records a full redraw if another session changed a value since this
+    //! one was last used.
+    //!
+    //! \returns The MenuSystem of the session, ready to be used.
+    MenuSystem& attach() {
+        if (_tree._p_attached != this) {
+            if (_tree._p_attached != nullptr)
+                _tree._p_attached->_ms.save_cursor(_tree._p_attached->_cursor);
+            _ms.restore_cursor(_cursor);
+            _tree._p_attached = this;
+        }
+        if (_version != _tree._version) {
+            _version = _tree._version;
+            _ms.invalidate();
+        }
+        return _ms;
+    }
+
+    //! \returns true if another session changed a value since this one was
+    //!          last used, so it should be displayed again.
+    bool is_stale() const { return _version != _tree._version; }
+
+    bool next(bool loop=false) { return changed(attach().next(loop)); }
+    bool prev(bool loop=false) { return changed(attach().prev(loop)); }
+    bool move_by(int16_t delta, bool loop=false) { return changed(attach().move_by(delta, loop)); }
+    bool move_to(menu_index_t index) { return attach().move_to(index); }
+    bool home() { return attach().home(); }
+    bool end() { return attach().end(); }
+    bool back(uint8_t levels=1) { return attach().back(levels); }
+
+    void select(bool reset=false) {
+        attach().select(reset);
+        changed(true);
+    }
+
+    void reset() {
+        attach().reset();
+        values_changed();
+    }
+
+    //! \brief Renders the current menu of the session with its renderer
+    void display() { attach().display(); }
+
+    //! \returns The changes the next display() renders; without attaching
+    //!          the session.
+    MenuChangeSet const& get_changes() const { return _ms.get_changes(); }
+
+    MenuTree& get_tree() const { return _tree; }
+
+private:
+    //! Tells the other sessions when the last call changed a value
+    bool changed(bool result) {
+        if (_ms.get_changes().get_flags() & MenuChangeSet::CHANGE_VALUE)
+            values_changed();
+        return result;
+    }
+
+    void values_changed() {
+        _version = ++_tree._version;
+    }
+
+private:
+    MenuSystem _ms;
+    MenuTree& _tree;
+    MenuCursor _cursor;
+    uint16_t _version;
+};
+
+#endif // MENU_SESSION_H
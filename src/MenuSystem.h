@@ -19,26 +19,464 @@
   #include <stdint.h> // uint8_t, uint32_t
   #include <stdlib.h>    /* size_t */
   #include <stdio.h>
+  #include <string.h>    /* strlen */
   #include <string>
   // String
   #include <string>
   #define String std::string
 #endif
 
+#ifndef MENUSYSTEM_REALLOC
+//! \brief The allocator used for the component list of heap backed menus
+//!
+//! Override together with MENUSYSTEM_FREE, e.g. to count allocations.
+#define MENUSYSTEM_REALLOC realloc
+#endif
+
+#ifndef MENUSYSTEM_FREE
+//! \brief Frees the component list allocated with MENUSYSTEM_REALLOC
+#define MENUSYSTEM_FREE free
+#endif
+
+#ifndef MENUSYSTEM_MIN_CAPACITY
+//! \brief The initial capacity of a heap backed Menu
+#define MENUSYSTEM_MIN_CAPACITY 4
+#endif
+
+#ifndef MENUSYSTEM_MAX_COMPONENTS
+//! \brief The maximum number of components of a Menu
+//!
+//! Selects menu_index_t, the type of the cursor of every Menu and of the
+//! dirty rows of a MenuChangeSet: one byte up to 255 components, two bytes
+//! above.
+#define MENUSYSTEM_MAX_COMPONENTS 255
+#endif
+
+#ifndef MENUSYSTEM_CURSOR_STATE_SIZE
+//! \brief The bytes a MenuCursor keeps for the edit state of the focused
+//!        component, see MenuComponent::save_cursor_state
+#define MENUSYSTEM_CURSOR_STATE_SIZE 3
+#endif
+
+#if MENUSYSTEM_MAX_COMPONENTS <= 255
+typedef uint8_t menu_index_t;
+#elif MENUSYSTEM_MAX_COMPONENTS <= 65535
+typedef uint16_t menu_index_t;
+#else
+#error "MENUSYSTEM_MAX_COMPONENTS must be at most 65535"
+#endif
+
+#if defined(ARDUINO) && defined(__AVR__)
+  #include <avr/pgmspace.h>
+  // Constant component tables are kept in flash and read with pgm_read_word
+  #define MENUSYSTEM_PROGMEM PROGMEM
+  #define MENUSYSTEM_PGM_READ_PTR(p) pgm_read_word(p)
+  #define MENUSYSTEM_PGM_READ_BYTE(p) pgm_read_byte(p)
+#else
+  // Flash is in the data address space, const data is already read-only
+  #define MENUSYSTEM_PROGMEM
+#endif
+
+//! \brief Declares a constant component table for a Menu
+//!
+//! The table is placed in flash/rodata and can be passed to the constexpr
+//! Menu constructor.
+//!
+//! \param table The name of the table.
+//! \param ... The addresses of the components.
+#define MENU_COMPONENTS(table, ...) \
+    MenuComponent* const table[] MENUSYSTEM_PROGMEM = { __VA_ARGS__ }
+
+#ifndef MENUSYSTEM_VALUE_BUFFER_SIZE
+//! \brief Size of the stack buffers used to format values
+#define MENUSYSTEM_VALUE_BUFFER_SIZE 16
+#endif
+
+//! \brief Callback for formatting a value into a caller supplied buffer
+//!
+//! \param value The value to convert.
+//! \param buffer The buffer to write the 0-terminated text to.
+//! \param size The size of buffer in bytes.
+using FormatValueBufferFnPtr = void (*)(const float value, char* buffer, size_t size);
+
+//! \brief Copies str into buffer, truncating it if needed
+//! \returns The length of the copied text.
+inline size_t menu_copy_string(const char* str, char* buffer, size_t size) {
+    if (size == 0)
+        return 0;
+    size_t len = 0;
+    while (len < size - 1 && str[len] != '\0') {
+        buffer[len] = str[len];
+        len++;
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+//! \brief Writes value with two decimals into buffer
+//!
+//! This is the default formatter of NumericMenuItem and
+//! NumericDisplayMenuItem; it matches String(value).
+//!
+//! \returns The length of the text written.
+inline size_t menu_format_float(float value, char* buffer, size_t size) {
+#if defined(ARDUINO)
+    // dtostrf doesn't know the size of its output buffer
+    char tmp[48];
+    dtostrf(value, 1, 2, tmp);
+    return menu_copy_string(tmp, buffer, size);
+#else
+    if (size == 0)
+        return 0;
+    int len = snprintf(buffer, size, "%.2f", value);
+    if (len < 0) {
+        buffer[0] = '\0';
+        return 0;
+    }
+    return (size_t) len < size ? (size_t) len : size - 1;
+#endif
+}
+
+//! \brief Formats value with the first formatter that is set
+//!
+//! format_buffer_fn is preferred as it doesn't use the heap; format_fn is
+//! the legacy String formatter; without either menu_format_float is used.
+//!
+//! \returns The length of the text written.
+inline size_t menu_format_value(float value, char* buffer, size_t size,
+                                const String (*format_fn)(const float value),
+                                FormatValueBufferFnPtr format_buffer_fn) {
+    if (size == 0)
+        return 0;
+    if (format_buffer_fn != nullptr) {
+        buffer[0] = '\0';
+        format_buffer_fn(value, buffer, size);
+        buffer[size - 1] = '\0';
+        return strlen(buffer);
+    }
+    if (format_fn != nullptr)
+        return menu_copy_string(format_fn(value).c_str(), buffer, size);
+    return menu_format_float(value, buffer, size);
+}
+
+#ifdef MENUSYSTEM_INSTRUMENT
+//! \brief The statistics of one instrumented operation
+//!
+//! The durations are in the unit of the clock passed to
+//! MenuStats::set_clock, and 0 without one.
+struct MenuStat {
+    uint32_t count;   //!< number of calls
+    uint32_t total;   //!< sum of the durations; wraps around
+    uint32_t min;
+    uint32_t max;
+
+    uint32_t get_average() const { return count != 0 ? total / count : 0; }
+};
+
+struct MenuStatsSnapshot;
+
+//! \brief Counters and durations of the hot paths of the library
+//!
+//! Only exists if MENUSYSTEM_INSTRUMENT is defined before MenuSystem.h is
+//! included; otherwise the hooks compile to nothing. The durations are
+//! taken with a clock of the application's choosing, e.g. micros() on a
+//! board, and kept for the whole program, whatever the number of
+//! MenuSystems.
+//!
+//! \code
+//! #define MENUSYSTEM_INSTRUMENT
+//! #include <MenuSystem.h>
+//!
+//! uint32_t clock_us() { return micros(); }
+//!
+//! void setup() {
+//!     MenuStats::set_clock(&clock_us);
+//! }
+//!
+//! void print_stats() {
+//!     MenuStatsSnapshot snapshot;
+//!     MenuStats::get_snapshot(snapshot, true);
+//!     char line[64];
+//!     for (uint8_t id = 0; id < MenuStats::NUM_STATS; ++id) {
+//!         snapshot.format(id, line, sizeof(line));
+//!         Serial.println(line);
+//!     }
+//! }
+//! \endcode
+//!
+//! \see MenuStatsSnapshot
+class MenuStats {
+public:
+    //! \brief The instrumented operations
+    enum Id {
+        DISPLAY,       //!< MenuSystem::display
+        RENDER,        //!< the renderer call of MenuSystem::display
+        SELECT,        //!< MenuSystem::select
+        SELECT_FN,     //!< the select function of a component
+        ADD_COMPONENT, //!< Menu::add_component
+        ALLOC,         //!< the reallocations of heap backed menus
+        NUM_STATS
+    };
+
+    //! \brief Returns the current time in any unit
+    using ClockFnPtr = uint32_t (*)();
+
+    //! \brief Sets the clock of the durations; nullptr only counts calls
+    static void set_clock(ClockFnPtr clock) { state().clock = clock; }
+
+    //! \returns The name of the operation id.
+    static const char* get_name(uint8_t id) {
+        static const char* const names[NUM_STATS] = {
+            "display", "render", "select", "select_fn", "add_component", "alloc"
+        };
+        return id < NUM_STATS ? names[id] : "";
+    }
+
+    //! \brief Copies the statistics
+    //!
+    //! \param[out] snapshot Receives the statistics.
+    //! \param[in] clear Starts new statistics after the copy, so successive
+    //!                  snapshots cover successive periods.
+    static void get_snapshot(MenuStatsSnapshot& snapshot, bool clear=false);
+
+    //! \brief Starts new statistics
+    static void clear() {
+        for (uint8_t id = 0; id < NUM_STATS; ++id)
+            state().stats[id] = MenuStat();
+    }
+
+    //! \returns The time of the clock, 0 without one.
+    static uint32_t now() {
+        ClockFnPtr clock = state().clock;
+        return clock != nullptr ? clock() : 0;
+    }
+
+    //! \brief Records a call to operation id that took duration
+    static void record(uint8_t id, uint32_t duration) {
+        MenuStat& stat = state().stats[id];
+        if (stat.count == 0 || duration < stat.min)
+            stat.min = duration;
+        if (stat.count == 0 || duration > stat.max)
+            stat.max = duration;
+        stat.count++;
+        stat.total += duration;
+    }
+
+private:
+    struct State {
+        ClockFnPtr clock;
+        MenuStat stats[NUM_STATS];
+    };
+
+    // A single instance across translation units, zero initialized
+    static State& state() {
+        static State state;
+        return state;
+    }
+};
+
+//! \brief A copy of the statistics of MenuStats
+struct MenuStatsSnapshot {
+    MenuStat stats[MenuStats::NUM_STATS];
+
+    //! \brief Writes a line like "display n=12 min=80 avg=95 max=210"
+    //! \returns The length of the text written.
+    size_t format(uint8_t id, char* buffer, size_t size) const {
+        if (size == 0)
+            return 0;
+        if (id >= MenuStats::NUM_STATS) {
+            buffer[0] = '\0';
+            return 0;
+        }
+        MenuStat const& stat = stats[id];
+        int len = snprintf(buffer, size, "%s n=%lu min=%lu avg=%lu max=%lu",
+                           MenuStats::get_name(id), (unsigned long) stat.count,
+                           (unsigned long) stat.min, (unsigned long) stat.get_average(),
+                           (unsigned long) stat.max);
+        if (len < 0) {
+            buffer[0] = '\0';
+            return 0;
+        }
+        return (size_t) len < size ? (size_t) len : size - 1;
+    }
+};
+
+inline void MenuStats::get_snapshot(MenuStatsSnapshot& snapshot, bool clear) {
+    for (uint8_t id = 0; id < NUM_STATS; ++id)
+        snapshot.stats[id] = state().stats[id];
+    if (clear)
+        MenuStats::clear();
+}
+
+//! \brief Records the duration of the enclosing scope in MenuStats
+class MenuStatScope {
+public:
+    explicit MenuStatScope(uint8_t id) : _start(MenuStats::now()), _id(id) {}
+    ~MenuStatScope() { MenuStats::record(_id, MenuStats::now() - _start); }
+
+private:
+    uint32_t _start;
+    uint8_t _id;
+};
+
+//! Times the rest of the enclosing scope as operation id of MenuStats
+#define MENUSYSTEM_STAT_SCOPE(id) MenuStatScope menu_stat_scope_(MenuStats::id)
+#else
+#define MENUSYSTEM_STAT_SCOPE(id)
+#endif
+
 class MenuSystem;
 class Menu;
 class MenuItem;
 class BackMenuItem;
 class NumericMenuItem;
+class NumericValueMenuItem;
+class ToggleMenuItem;
+class NumericDisplayMenuItem;
+class TextEditMenuItem;
+
+#ifndef MENUSYSTEM_MAX_DIRTY
+//! \brief Number of rows a MenuChangeSet tracks before it falls back to a
+//!        full redraw
+#define MENUSYSTEM_MAX_DIRTY 4
+#endif
+
+#ifndef MENUSYSTEM_MAX_DEPTH
+//! \brief Number of levels a MenuPath stores, including the root menu
+//!
+//! Deeper trees still work; the levels that don't fit are found by walking
+//! the parents of the current menu.
+#define MENUSYSTEM_MAX_DEPTH 8
+#endif
+
+//! \brief The changes made to the current menu since it was last displayed
+//!
+//! MenuSystem records every state transition (cursor moves, value edits,
+//! focus toggles and menu switches) in a MenuChangeSet and passes it to
+//! MenuComponentRenderer::render_changes from MenuSystem::display. Renderers
+//! can use it to redraw only the rows that changed.
+//!
+//! At most MENUSYSTEM_MAX_DIRTY rows are tracked between two frames; when
+//! more rows change, the set degrades to a full redraw.
+//!
+//! \see MenuSystem::display
+//! \see MenuComponentRenderer::render_changes
+class MenuChangeSet {
+public:
+    //! \brief The kinds of change, combined as a bit mask
+    enum ChangeFlags {
+        CHANGE_NONE   = 0x00,
+        CHANGE_CURSOR = 0x01, //!< the current component moved
+        CHANGE_VALUE  = 0x02, //!< the value of a component changed
+        CHANGE_FOCUS  = 0x04, //!< a component gained or lost focus
+        CHANGE_MENU   = 0x08, //!< the current menu was switched
+        CHANGE_SCROLL = 0x10, //!< the viewport of the menu scrolled
+        CHANGE_FILTER = 0x20, //!< the components shown by the filter changed
+        CHANGE_ALL    = 0x80  //!< everything has to be redrawn
+    };
+
+public:
+    //! \brief Construct a MenuChangeSet that requests a full redraw
+    MenuChangeSet() : _flags(CHANGE_ALL), _num_dirty(0) {}
+
+    //! \returns The ChangeFlags of all changes recorded since the last clear.
+    uint8_t get_flags() const { return _flags; }
+
+    //! \returns true if nothing changed since the last clear.
+    bool is_empty() const { return _flags == CHANGE_NONE; }
+
+    //! \returns true if the whole menu has to be redrawn.
+    bool is_full() const { return (_flags & (CHANGE_MENU | CHANGE_SCROLL | CHANGE_FILTER | CHANGE_ALL)) != 0; }
+
+    //! \returns The number of rows listed as dirty.
+    uint8_t get_num_dirty() const { return _num_dirty; }
+
+    //! \returns The component index of the i-th dirty row.
+    menu_index_t get_dirty(uint8_t i) const { return _dirty[i]; }
+
+    //! \brief Returns true if the component at index has to be redrawn
+    //! \param[in] index The index of the component in the current menu.
+    bool is_dirty(menu_index_t index) const {
+        if (is_full())
+            return true;
+        for (uint8_t i = 0; i < _num_dirty; ++i)
+            if (_dirty[i] == index)
+                return true;
+        return false;
+    }
+
+    //! \brief Records a change of the component at index
+    //! \param[in] flags The ChangeFlags describing the change.
+    //! \param[in] index The index of the component in the current menu.
+    void mark(uint8_t flags, menu_index_t index) {
+        _flags |= flags;
+        if (is_full())
+            return;
+        for (uint8_t i = 0; i < _num_dirty; ++i)
+            if (_dirty[i] == index)
+                return;
+        if (_num_dirty < MENUSYSTEM_MAX_DIRTY)
+            _dirty[_num_dirty++] = index;
+        else
+            _flags |= CHANGE_ALL;
+    }
+
+    //! \brief Records a change that requires a full redraw
+    void mark_all(uint8_t flags=CHANGE_ALL) { _flags |= flags | CHANGE_ALL; }
+
+    //! \brief Forgets all recorded changes
+    void clear() {
+        _flags = CHANGE_NONE;
+        _num_dirty = 0;
+    }
+
+private:
+    uint8_t _flags;
+    uint8_t _num_dirty;
+    menu_index_t _dirty[MENUSYSTEM_MAX_DIRTY];
+};
 
 class MenuComponentRenderer {
 public:
     virtual void render(Menu const& menu) const = 0;
 
+    //! \brief Renders the changes made to menu since the last frame
+    //!
+    //! Called by MenuSystem::display. The default implementation redraws the
+    //! whole menu with render(); override it to redraw only the rows listed
+    //! in changes.
+    //!
+    //! \param[in] menu The current menu.
+    //! \param[in] changes What changed since the last call.
+    virtual void render_changes(Menu const& menu, MenuChangeSet const& changes) const { render(menu); }
+
     virtual void render_menu_item(MenuItem const& menu_item) const = 0;
     virtual void render_back_menu_item(BackMenuItem const& menu_item) const = 0;
     virtual void render_numeric_menu_item(NumericMenuItem const& menu_item) const = 0;
+
+    //! \brief Renders a NumericMenuItemT of any value type
+    //!
+    //! The default implementation renders it like a MenuItem.
+    virtual void render_numeric_value_menu_item(NumericValueMenuItem const& menu_item) const;
     virtual void render_menu(Menu const& menu) const = 0;
+
+    //! \brief Renders a ToggleMenuItem
+    //!
+    //! The default implementation renders nothing; MenuComponentRenderer2
+    //! requires it.
+    //!
+    //! This hook and the two below add three entries to the vtable of every
+    //! renderer class, which avr-gcc keeps in RAM: 6 bytes per renderer
+    //! class on AVR.
+    virtual void render_toggle_menu_item(ToggleMenuItem const& menu_item) const {}
+
+    //! \brief Renders a NumericDisplayMenuItem
+    //! \see render_toggle_menu_item
+    virtual void render_numeric_display_menu_item(NumericDisplayMenuItem const& menu_item) const {}
+
+    //! \brief Renders a TextEditMenuItem
+    //! \see render_toggle_menu_item
+    virtual void render_text_edit_menu_item(TextEditMenuItem const& menu_item) const {}
 };
 
 //! \brief Abstract base class that represents a component in the menu
@@ -63,15 +501,43 @@ public:
     //! \param menu_component The menu component being selected.
     using SelectFnPtr = void (*)(MenuComponent* menu_component);
 
+    //! \brief Identifies the class of a component
+    //!
+    //! Lets renderers dispatch on the class of a component without a virtual
+    //! call, see StaticMenuRenderer. Subclasses keep the type of their parent
+    //! class unless they call set_type.
+    //!
+    //! The tag is a byte in every component. On 32 and 64 bit hosts it fits
+    //! in padding; on AVR, which doesn't pad, every component is a byte
+    //! larger for it.
+    enum Type {
+        TYPE_MENU,
+        TYPE_MENU_ITEM,
+        TYPE_BACK_MENU_ITEM,
+        TYPE_NUMERIC_MENU_ITEM,
+        TYPE_NUMERIC_VALUE_MENU_ITEM,
+        TYPE_TOGGLE_MENU_ITEM,
+        TYPE_NUMERIC_DISPLAY_MENU_ITEM,
+        TYPE_TEXT_EDIT_MENU_ITEM,
+        TYPE_USER = 0x40 //!< The first type for client classes
+    };
+
 public:
     //! \brief Construct a MenuComponent
     //! \param[in] name The name of the menu component that is displayed in
     //!                 clients.
-    MenuComponent(const char* name, SelectFnPtr select_fn)
+    //! \param[in] select_fn The function to call when the component is
+    //!                      selected; ignored if MENUSYSTEM_NO_SELECT_FN is
+    //!                      defined.
+    //! \param[in] type A MenuComponent::Type.
+    constexpr MenuComponent(const char* name, SelectFnPtr select_fn, uint8_t type=TYPE_USER)
     : _name(name),
+#ifndef MENUSYSTEM_NO_SELECT_FN
+    _select_fn(select_fn),
+#endif
     _has_focus(false),
     _is_current(false),
-    _select_fn(select_fn) {
+    _type(type) {
     }
 
 
@@ -84,6 +550,9 @@ public:
     //! \returns The component's name.
     const char* get_name() const { return _name; };
 
+    //! \returns The MenuComponent::Type of the component.
+    uint8_t get_type() const { return _type; }
+
     //! \brief Renders the component using the given MenuComponentRenderer
     //!
     //! This is the `accept` method in the visitor design pattern. It should
@@ -129,10 +598,49 @@ public:
     //! \see MenuComponent::set_current
     bool is_current() const { return _is_current; }
 
+#ifndef MENUSYSTEM_NO_SELECT_FN
     //! \brief Sets the function to call when the MenuItem is selected
     //! \param[in] select_fn The function to call when the MenuItem is
     //!                      selected.
     void set_select_function(SelectFnPtr select_fn) { _select_fn = select_fn; }
+#endif
+
+    //! \brief Writes the state of the component that should be persisted
+    //!
+    //! Used by MenuPersistence. The number of bytes must not depend on the
+    //! state, so each record keeps its place in storage.
+    //!
+    //! \param[out] buffer Receives the state.
+    //! \param[in] size The size of buffer.
+    //! \returns The number of bytes written; 0 if the component has no state.
+    virtual uint8_t save_state(uint8_t* buffer, uint8_t size) const { return 0; }
+
+    //! \brief Restores a state written by save_state
+    //!
+    //! \param[in] buffer The state.
+    //! \param[in] size The number of bytes in buffer.
+    //! \returns true if the state was restored, false if it was rejected.
+    virtual bool load_state(const uint8_t* buffer, uint8_t size) { return false; }
+
+    //! \brief Writes the edit state of the component while it has focus
+    //!
+    //! Used by MenuSystem::save_cursor, so several MenuSessions can edit
+    //! the same component: the state a session leaves behind is put back
+    //! with load_cursor_state when it uses the tree again. Components that
+    //! keep more than their value while focused, e.g. a cursor in a text,
+    //! override both functions.
+    //!
+    //! \param[out] buffer Receives the state.
+    //! \param[in] size The size of buffer, MENUSYSTEM_CURSOR_STATE_SIZE.
+    //! \returns The number of bytes written; 0 if there is no such state.
+    virtual uint8_t save_cursor_state(uint8_t* buffer, uint8_t size) const { return 0; }
+
+    //! \brief Restores a state written by save_cursor_state
+    //!
+    //! \param[in] buffer The state.
+    //! \param[in] size The number of bytes in buffer.
+    //! \returns true if the state was restored, false if it was rejected.
+    virtual bool load_cursor_state(const uint8_t* buffer, uint8_t size) { return size == 0; }
 
 protected:
     //! \brief Processes the next action
@@ -171,6 +679,22 @@ protected:
     //! \see MenuComponent::has_focus
     virtual bool prev(bool loop=false) = 0;
 
+    //! \brief Processes delta next actions, or -delta prev actions, at once
+    //!
+    //! The default implementation calls next or prev |delta| times.
+    //! Components override it when they can do the same in fewer steps,
+    //! e.g. for an accelerated encoder, see MenuAccelerator.
+    //!
+    //! \returns true if any of the actions was processed, false otherwise.
+    virtual bool move_by(int16_t delta, bool loop=false) {
+        bool changed = false;
+        for (; delta > 0; --delta)
+            changed |= next(loop);
+        for (; delta < 0; ++delta)
+            changed |= prev(loop);
+        return changed;
+    }
+
     //! \brief Resets the component to its initial state
     virtual void reset() = 0;
 
@@ -193,7 +717,19 @@ protected:
     //!
     //! \see MenuComponent::has_focus
     //! \see NumericMenuComponent
-    virtual Menu* select() { if (_select_fn != nullptr) _select_fn(this); return nullptr; }
+    virtual Menu* select() { call_select_fn(); return nullptr; }
+
+    //! \brief Calls the select function, if any
+    //!
+    //! Does nothing if MENUSYSTEM_NO_SELECT_FN is defined.
+    void call_select_fn() {
+#ifndef MENUSYSTEM_NO_SELECT_FN
+        if (_select_fn != nullptr) {
+            MENUSYSTEM_STAT_SCOPE(SELECT_FN);
+            _select_fn(this);
+        }
+#endif
+    }
 
     //! \brief Set the current state of the component
     //!
@@ -202,11 +738,22 @@ protected:
     //! \see is_current
     void set_current(bool is_current=true) { _is_current = is_current; }
 
+    //! \brief Sets the MenuComponent::Type of the component
+    //!
+    //! Client classes that need their own renderer hook set a type from
+    //! TYPE_USER up in their constructor.
+    void set_type(uint8_t type) { _type = type; }
+
 protected:
     const char* _name;
-    bool _has_focus;
-    bool _is_current;
+#ifndef MENUSYSTEM_NO_SELECT_FN
     SelectFnPtr _select_fn;
+#endif
+    // The flags share a byte and come last, so the small members of
+    // subclasses can be laid out in the tail padding
+    bool _has_focus : 1;
+    bool _is_current : 1;
+    uint8_t _type;
 };
 
 
@@ -225,7 +772,7 @@ public:
     //!                 clients.
     //! \param[in] select_fn The function to call when the MenuItem is
     //!                      selected.
-    MenuItem(const char* name, SelectFnPtr select_fn) : MenuComponent(name, select_fn) {}
+    constexpr MenuItem(const char* name, SelectFnPtr select_fn) : MenuComponent(name, select_fn, TYPE_MENU_ITEM) {}
 
     //! \copydoc MenuComponent::render
     virtual void render(MenuComponentRenderer const& renderer) const { renderer.render_menu_item(*this); }
@@ -256,6 +803,8 @@ protected:
         return nullptr;
     }
 
+    //! \brief Construct a MenuItem subclass of the given MenuComponent::Type
+    constexpr MenuItem(const char* name, SelectFnPtr select_fn, uint8_t type) : MenuComponent(name, select_fn, type) {}
 };
 
 //! \brief A MenuComponent that can contain other MenuComponents.
@@ -268,40 +817,223 @@ protected:
 //! \see MenuItem
 class Menu : public MenuComponent {
     friend class MenuSystem;
+    friend class MenuPath;
+    friend class DataSourceMenu;
 public:
+    //! \brief Construct a Menu that keeps its components on the heap
+    //!
+    //! The component list grows geometrically as components are added. Use
+    //! Menu::reserve to allocate it once up front, or StaticMenu to avoid the
+    //! heap entirely.
     Menu(const char* name, SelectFnPtr select_fn=nullptr)
-    : MenuComponent(name, select_fn),
+    : MenuComponent(name, select_fn, TYPE_MENU),
+    _num_components(0),
+    _current_component_num(0),
+    _previous_component_num(0),
+    _first_visible(0),
+    _capacity(0),
+    _storage(STORAGE_HEAP),
+    _reset_pending(false),
     _p_current_component(nullptr),
     _menu_components(nullptr),
-    _p_parent(nullptr),
-    _num_components(0),
+    _p_parent(nullptr) {
+    }
+
+    //! \brief Construct a Menu from a constant component table
+    //!
+    //! The table is not copied: the Menu only keeps a pointer to it, so a
+    //! table declared with MENU_COMPONENTS lives in flash/rodata. The Menu
+    //! object itself stays in RAM like any other: its vptr, name, select
+    //! function, cursor, current component, table pointer and parent link,
+    //! see the footprint report. The parent link is an ordinary field set at
+    //! construction, not kept in flash. The constructor is constexpr, so
+    //! global menus are laid out by the compiler and need no code at startup.
+    //! Components can't be added to such a menu.
+    //!
+    //! \code
+    //! extern Menu mu1;
+    //! MenuItem mm_mi1("Item 1", &on_item1_selected);
+    //! MenuItem mu1_mi1("Item 2", &on_item2_selected);
+    //! MENU_COMPONENTS(mu1_components, &mu1_mi1);
+    //! MENU_COMPONENTS(root_components, &mm_mi1, &mu1);
+    //! Menu root("", root_components);
+    //! Menu mu1("Submenu", mu1_components, &root);
+    //! MenuSystem ms(my_renderer, root);
+    //! \endcode
+    //!
+    //! \param[in] components The table of components.
+    //! \param[in] p_parent The parent menu, nullptr for the root menu.
+    //! \param[in] select_fn The function to call when the Menu is selected.
+    template <size_t N>
+    constexpr Menu(const char* name, MenuComponent* const (&components)[N],
+                   Menu* p_parent=nullptr, SelectFnPtr select_fn=nullptr)
+    : MenuComponent(name, select_fn, TYPE_MENU),
+    _num_components(N),
     _current_component_num(0),
-    _previous_component_num(0) {
+    _previous_component_num(0),
+    _first_visible(0),
+    _capacity(N),
+    _storage(STORAGE_CONST),
+    _reset_pending(false),
+    _p_current_component(nullptr),
+    _menu_components(const_cast<MenuComponent**>(components)),
+    _p_parent(p_parent) {
+        static_assert(N <= MENUSYSTEM_MAX_COMPONENTS, "Too many components, see MENUSYSTEM_MAX_COMPONENTS");
+    }
+
+    virtual ~Menu() {
+        if (_storage == STORAGE_HEAP)
+            MENUSYSTEM_FREE(_menu_components);
     }
 
     //! \brief Adds a MenuItem to the Menu
-    void add_item(MenuItem* p_item) { add_component((MenuComponent*) p_item); }
+    //! \returns true if the item was added, false if the Menu is full.
+    bool add_item(MenuItem* p_item) { return add_component((MenuComponent*) p_item); }
 
     //! \brief Adds a Menu to the Menu
-    void add_menu(Menu* p_menu) {
-        add_component((MenuComponent*) p_menu);
+    //! \returns true if the menu was added, false if the Menu is full.
+    bool add_menu(Menu* p_menu) {
+        if (!add_component((MenuComponent*) p_menu))
+            return false;
         p_menu->set_parent(this);
+        return true;
+    }
+
+    //! \brief Makes room for at least capacity components
+    //!
+    //! Only heap backed menus can grow; for a StaticMenu this just checks that
+    //! capacity fits.
+    //!
+    //! \param[in] capacity The number of components to make room for.
+    //! \returns true if the Menu can hold capacity components, false if the
+    //!          allocation failed. The existing components are kept either way.
+    bool reserve(menu_index_t capacity) {
+        if (capacity <= _capacity)
+            return true;
+        if (_storage != STORAGE_HEAP)
+            return false;
+
+        MenuComponent** p_components;
+        {
+            MENUSYSTEM_STAT_SCOPE(ALLOC);
+            p_components = (MenuComponent**) MENUSYSTEM_REALLOC(
+                _menu_components, capacity * sizeof(MenuComponent*));
+        }
+        if (p_components == nullptr)
+            return false;
+
+        _menu_components = p_components;
+        _capacity = capacity;
+        return true;
     }
 
+    //! \returns The number of components the Menu can hold without growing.
+    menu_index_t get_capacity() const { return _capacity; }
+
     MenuComponent const* get_current_component() const { return _p_current_component; }
-    MenuComponent const* get_menu_component(uint8_t index) const { return _menu_components[index]; }
+    MenuComponent const* get_menu_component(menu_index_t index) const { return component_at(index); }
+
+    menu_index_t get_num_components() const { return _num_components; }
+    menu_index_t get_current_component_num() const { return _current_component_num; }
+    menu_index_t get_previous_component_num() const {return _previous_component_num;}
+
+    //! \brief How the viewport follows the cursor
+    //! \see MenuSystem::set_viewport
+    enum ScrollPolicy {
+        SCROLL_EDGE,   //!< scroll only when the cursor leaves the viewport
+        SCROLL_CENTER, //!< keep the cursor in the middle row when possible
+        SCROLL_PAGE    //!< show whole pages of rows
+    };
 
-    uint8_t get_num_components() const { return _num_components; }
-    uint8_t get_current_component_num() const { return _current_component_num; }
-    uint8_t get_previous_component_num() const {return _previous_component_num;}
+    //! \brief Returns the index of the first component in the viewport
+    //!
+    //! Maintained by MenuSystem when a viewport is set, 0 otherwise.
+    //! Renderers should only visit the components from
+    //! get_first_visible() to get_first_visible() + get_num_visible() - 1.
+    //!
+    //! \see MenuSystem::set_viewport
+    menu_index_t get_first_visible() const { return _first_visible; }
+
+    //! \brief Returns the number of components in a viewport of rows rows
+    uint8_t get_num_visible(uint8_t rows) const {
+        menu_index_t num_left = _num_components - _first_visible;
+        return rows < num_left ? rows : num_left;
+    }
 
     //! \copydoc MenuComponent::render
     void render(MenuComponentRenderer const& renderer) const {renderer.render_menu(*this);}
 
+    //! \copydoc MenuComponent::save_state
+    //!
+    //! The state of a Menu is the index of its current component, in
+    //! sizeof(menu_index_t) bytes, little endian.
+    //! A menu with a pending reset saves the state it will be reset to.
+    virtual uint8_t save_state(uint8_t* buffer, uint8_t size) const {
+        if (size < sizeof(menu_index_t))
+            return 0;
+        menu_index_t index = is_reset_pending() ? 0 : _current_component_num;
+        for (uint8_t i = 0; i < sizeof(menu_index_t); ++i)
+            buffer[i] = (uint8_t) (index >> (8 * i));
+        return sizeof(menu_index_t);
+    }
+
+    //! \copydoc MenuComponent::load_state
+    //!
+    //! Applies the pending resets of the menu and its parents first, so they
+    //! don't undo the state loaded.
+    virtual bool load_state(const uint8_t* buffer, uint8_t size) {
+        if (size != sizeof(menu_index_t))
+            return false;
+        menu_index_t index = 0;
+        for (uint8_t i = 0; i < sizeof(menu_index_t); ++i)
+            index |= (menu_index_t) buffer[i] << (8 * i);
+        if (index >= _num_components)
+            return false;
+        apply_resets();
+        move_to(index);
+        return true;
+    }
+
+    //! \brief Returns true if the menu or one of its parents was reset but
+    //!        not visited since
+    //!
+    //! The state of such a menu, e.g. get_current_component_num(), is the
+    //! state from before the reset until it's entered again.
+    bool is_reset_pending() const {
+        for (Menu const* p_menu = this; p_menu != nullptr; p_menu = p_menu->_p_parent)
+            if (p_menu->_reset_pending)
+                return true;
+        return false;
+    }
+
 protected:
     void set_parent(Menu* p_parent) { _p_parent = p_parent; }
+
+    //! \brief Returns the component at index
+    //!
+    //! Reads constant tables from program memory on targets where flash is
+    //! not in the data address space.
+    MenuComponent* component_at(menu_index_t index) const {
+#if defined(MENUSYSTEM_PGM_READ_PTR)
+        if (_storage == STORAGE_CONST)
+            return (MenuComponent*) MENUSYSTEM_PGM_READ_PTR(&_menu_components[index]);
+#endif
+        return _menu_components[index];
+    }
+
+    //! \brief Prepares the Menu for becoming the current menu
+    //!
+    //! Menus built from a constant table don't mark their first component as
+    //! current when they are constructed; this is done on the first visit.
+    virtual void enter() {
+        apply_reset();
+        if (_p_current_component == nullptr && _num_components) {
+            _p_current_component = component_at(_current_component_num);
+            _p_current_component->set_current();
+        }
+    }
     Menu const* get_parent() const { return _p_parent; }
-    bool has_children() const { return _menu_components > 0; }
+    bool has_children() const { return _num_components > 0; }
 
     //! \brief Activates the current selection
     //!
@@ -311,7 +1043,7 @@ protected:
         if (!_num_components)
             return nullptr;
 
-        MenuComponent* pComponent = _menu_components[_current_component_num];
+        MenuComponent* pComponent = component_at(_current_component_num);
 
         if (pComponent == nullptr)
             return nullptr;
@@ -320,55 +1052,105 @@ protected:
     }
 
     //! \copydoc MenuComponent::next
-    virtual bool next(bool loop=false) {
-        _previous_component_num = _current_component_num;
+    virtual bool next(bool loop=false) { return move_by(1, loop); }
 
-        if (!_num_components) {
-            return false;
-        } else if (_current_component_num != _num_components - 1) {
-            _current_component_num++;
-            _p_current_component = _menu_components[_current_component_num];
-
-            _p_current_component->set_current();
-            _menu_components[_previous_component_num]->set_current(false);
-            return true;
-        } else if (loop) {
-            _current_component_num = 0;
-            _p_current_component = _menu_components[_current_component_num];
+    //! \copydoc MenuComponent::prev
+    virtual bool prev(bool loop=false) { return move_by(-1, loop); }
 
-            _p_current_component->set_current();
-            _menu_components[_previous_component_num]->set_current(false);
+    //! \copybrief MenuComponent::move_by
+    //!
+    //! Moves the cursor by delta components in a single transition.
+    //!
+    //! \param[in] delta The number of components to move; negative values
+    //!                  move towards the first component.
+    //! \param[in] loop if true the cursor wraps around the ends of the menu;
+    //!                 otherwise it stops at the first or last component.
+    //! \returns true if the cursor moved, false otherwise.
+    virtual bool move_by(int16_t delta, bool loop=false) {
+        if (!_num_components)
+            return false;
 
-            return true;
+        int32_t index = (int32_t) _current_component_num + delta;
+        if (loop) {
+            index %= _num_components;
+            if (index < 0)
+                index += _num_components;
+        } else if (index < 0) {
+            index = 0;
+        } else if (index >= _num_components) {
+            index = _num_components - 1;
         }
-        return false;
+        return move_to((menu_index_t) index);
     }
 
+    //! \brief Scrolls the viewport so the current component is visible
+    //!
+    //! \param[in] rows The number of rows of the viewport; 0 shows all rows.
+    //! \param[in] policy A ScrollPolicy.
+    //! \returns true if the first visible component changed.
+    virtual bool scroll_to_current(uint8_t rows, uint8_t policy) {
+        menu_index_t first = _first_visible;
+
+        if (rows == 0 || _num_components <= rows) {
+            first = 0;
+        } else if (policy == SCROLL_PAGE) {
+            first = _current_component_num - _current_component_num % rows;
+        } else {
+            if (policy == SCROLL_CENTER)
+                first = _current_component_num > rows / 2 ? _current_component_num - rows / 2 : 0;
+            else if (_current_component_num < first)
+                first = _current_component_num;
+            else if (_current_component_num >= first + rows)
+                first = _current_component_num - rows + 1;
+            if (first > _num_components - rows)
+                first = _num_components - rows;
+        }
 
-    //! \copydoc MenuComponent::prev
-    virtual bool prev(bool loop=false) {
-        _previous_component_num = _current_component_num;
+        if (first == _first_visible)
+            return false;
+        _first_visible = first;
+        return true;
+    }
 
-        if (!_num_components) {
+    //! \brief Moves the cursor to the first or last component
+    //! \returns true if the cursor moved, false otherwise.
+    virtual bool move_to_end(bool last) {
+        if (!_num_components)
             return false;
-        } else if (_current_component_num != 0) {
-            _current_component_num--;
-            _p_current_component = _menu_components[_current_component_num];
+        return move_to(last ? _num_components - 1 : 0);
+    }
 
-            _p_current_component->set_current();
-            _menu_components[_previous_component_num]->set_current(false);
+    //! \brief Makes the component at index the current one
+    //!
+    //! \returns true if the cursor moved; false if index is out of range or
+    //!          already current.
+    bool move_to(menu_index_t index) {
+        _previous_component_num = _current_component_num;
 
-            return true;
-        } else if (loop) {
-            _current_component_num = _num_components - 1;
-            _p_current_component = _menu_components[_current_component_num];
+        if (index >= _num_components || index == _current_component_num)
+            return false;
 
-            _p_current_component->set_current();
-            _menu_components[_previous_component_num]->set_current(false);
+        if (_p_current_component != nullptr)
+            _p_current_component->set_current(false);
+        _current_component_num = index;
+        _p_current_component = component_at(index);
+        _p_current_component->set_current();
+        return true;
+    }
 
-            return true;
-        }
-        return false;
+    //! \brief Returns the position of the cursor, see MenuSystem::save_cursor
+    //!
+    //! The index of the current component; subclasses that page their
+    //! components return a position that survives paging.
+    virtual uint16_t get_cursor_position() const { return _current_component_num; }
+
+    //! \brief Moves the cursor to a position returned by get_cursor_position
+    //! \returns false if position is out of range.
+    virtual bool set_cursor_position(uint16_t position) {
+        if (position >= _num_components)
+            return false;
+        move_to((menu_index_t) position);
+        return true;
     }
 
     //! \copydoc MenuComponent::select
@@ -378,25 +1160,113 @@ protected:
     }
 
     //! \copydoc MenuComponent::reset
-    virtual void reset() {
-        for (int i = 0; i < _num_components; ++i)
-            _menu_components[i]->reset();
+    //!
+    //! The reset is lazy and takes O(1): it's only recorded, and applied by
+    //! apply_reset() the next time the menu is entered. Applying it resets
+    //! the components of the menu, which for sub menus again only records
+    //! the reset, so resetting a tree costs nothing for the menus that
+    //! aren't visited.
+    virtual void reset() { _reset_pending = true; }
+
+    //! \brief Applies a reset recorded by reset(), if any
+    void apply_reset() {
+        if (!_reset_pending)
+            return;
+        _reset_pending = false;
+        reset_state();
+    }
+
+    //! \brief Applies the pending resets from the root menu down to this menu
+    void apply_resets() {
+        if (_p_parent != nullptr)
+            _p_parent->apply_resets();
+        apply_reset();
+    }
 
-        _p_current_component->set_current(false);
+    //! \brief Puts the cursor back on the first component and resets the
+    //!        components
+    //!
+    //! Called by apply_reset(); subclasses with more state override this
+    //! instead of reset().
+    virtual void reset_state() {
+        for (menu_index_t i = 0; i < _num_components; ++i)
+            component_at(i)->reset();
+
+        if (_p_current_component != nullptr)
+            _p_current_component->set_current(false);
         _previous_component_num = 0;
         _current_component_num = 0;
-        _p_current_component = _num_components ? _menu_components[0] : nullptr;
-        _p_current_component->set_current();
+        _first_visible = 0;
+        _p_current_component = _num_components ? component_at(0) : nullptr;
+        if (_p_current_component != nullptr)
+            _p_current_component->set_current();
     }
 
-    void add_component(MenuComponent* p_component) {
-        // Resize menu component list, keeping existing items.
-        // If it fails, there the item is not added and the function returns.
-        _menu_components = (MenuComponent**) realloc(_menu_components,
-                                                    (_num_components + 1)
-                                                    * sizeof(MenuComponent*));
-        if (_menu_components == nullptr)
-        return;
+    //! \brief Construct a Menu that keeps its components in external storage
+    //!
+    //! Used by StaticMenu; the storage is never reallocated or freed.
+    //!
+    //! \param[in] p_storage The array to store the components in.
+    //! \param[in] capacity The number of elements in p_storage.
+    Menu(const char* name, SelectFnPtr select_fn,
+         MenuComponent** p_storage, menu_index_t capacity)
+    : MenuComponent(name, select_fn, TYPE_MENU),
+    _num_components(0),
+    _current_component_num(0),
+    _previous_component_num(0),
+    _first_visible(0),
+    _capacity(capacity),
+    _storage(STORAGE_STATIC),
+    _reset_pending(false),
+    _p_current_component(nullptr),
+    _menu_components(p_storage),
+    _p_parent(nullptr) {
+    }
+
+    //! \brief Sets how many components of the storage are in use
+    //!
+    //! For subclasses that fill their storage themselves, see DataSourceMenu.
+    //! The cursor is moved to the last component if it's out of range.
+    //!
+    //! \param[in] num The number of components; at most the capacity.
+    void set_num_components(menu_index_t num) {
+        if (num > _capacity)
+            num = _capacity;
+
+        if (_p_current_component != nullptr)
+            _p_current_component->set_current(false);
+        _num_components = num;
+        if (_current_component_num >= num)
+            _current_component_num = num ? num - 1 : 0;
+        if (_previous_component_num >= num)
+            _previous_component_num = _current_component_num;
+        if (_first_visible >= num)
+            _first_visible = 0;
+        _p_current_component = num ? component_at(_current_component_num) : nullptr;
+        if (_p_current_component != nullptr)
+            _p_current_component->set_current();
+    }
+
+    //! \brief Appends a component to the Menu
+    //!
+    //! Heap backed menus double their capacity when they are full, so
+    //! building a menu of n components costs O(log n) reallocations.
+    //!
+    //! \returns true if the component was added; false if the Menu already
+    //!          holds MENUSYSTEM_MAX_COMPONENTS components, its static
+    //!          storage is full or the allocation failed.
+    bool add_component(MenuComponent* p_component) {
+        MENUSYSTEM_STAT_SCOPE(ADD_COMPONENT);
+        if (_num_components == _capacity) {
+            if (_num_components == MENUSYSTEM_MAX_COMPONENTS)
+                return false;
+
+            uint32_t capacity = _capacity ? 2 * (uint32_t) _capacity : MENUSYSTEM_MIN_CAPACITY;
+            if (capacity > MENUSYSTEM_MAX_COMPONENTS)
+                capacity = MENUSYSTEM_MAX_COMPONENTS;
+            if (!reserve(capacity))
+                return false;
+        }
 
         _menu_components[_num_components] = p_component;
 
@@ -406,75 +1276,903 @@ protected:
         }
 
         _num_components++;
+        return true;
     }
 
 private:
+    enum Storage {
+        STORAGE_HEAP,   //!< realloc'ed and owned by the Menu
+        STORAGE_STATIC, //!< fixed size, owned by a subclass
+        STORAGE_CONST   //!< read-only table, see MENU_COMPONENTS
+    };
+
+    // A copy would free the component list of a heap backed Menu twice
+    Menu(Menu const&);
+    Menu& operator=(Menu const&);
+
+private:
+    // The small members come first to fill the tail padding of MenuComponent
+    menu_index_t _num_components;
+    menu_index_t _current_component_num;
+    menu_index_t _previous_component_num;
+    menu_index_t _first_visible;
+    menu_index_t _capacity;
+    uint8_t _storage : 2;
+    uint8_t _reset_pending : 1;
     MenuComponent* _p_current_component;
     MenuComponent** _menu_components;
     Menu* _p_parent;
-    uint8_t _num_components;
-    uint8_t _current_component_num;
-    uint8_t _previous_component_num;
 };
 
+//! \brief A Menu that stores up to N components inline
+//!
+//! StaticMenu never touches the heap: its component list is a member array
+//! sized at compile time. It can be used anywhere a Menu is used, including
+//! as the root menu of a MenuSystem.
+//!
+//! \tparam N The maximum number of components.
+//!
+//! \see Menu
+template <menu_index_t N>
+class StaticMenu : public Menu {
+    static_assert(N > 0, "StaticMenu needs room for at least one component");
+public:
+    StaticMenu(const char* name, SelectFnPtr select_fn=nullptr)
+    : Menu(name, select_fn, _components, N) {
+    }
+
+private:
+    MenuComponent* _components[N];
+};
+
+
+//! \brief Compares a name with the query of a MenuFilter
+//!
+//! \param[in] name The name of a component.
+//! \param[in] query The query; only the first length characters are used.
+//! \param[in] mode A combination of MenuFilter::Mode flags.
+//! \returns true if name starts with the query, or contains it with
+//!          MenuFilter::FILTER_SUBSTRING.
+inline bool menu_name_matches(const char* name, const char* query, uint8_t length, uint8_t mode) {
+    for (;;) {
+        uint8_t i = 0;
+        for (; i < length && name[i] != '\0'; ++i) {
+            char a = name[i];
+            char b = query[i];
+            if (!(mode & 0x02)) { // MenuFilter::FILTER_MATCH_CASE
+                if (a >= 'A' && a <= 'Z')
+                    a += 'a' - 'A';
+                if (b >= 'A' && b <= 'Z')
+                    b += 'a' - 'A';
+            }
+            if (a != b)
+                break;
+        }
+        if (i == length)
+            return true;
+        if (!(mode & 0x01) || *name++ == '\0') // MenuFilter::FILTER_SUBSTRING
+            return false;
+    }
+}
+
+//! \brief Narrows the components of the current menu to those matching a
+//!        query typed character by character
+//!
+//! A MenuFilter is attached to a MenuSystem with MenuSystem::set_filter and
+//! driven by MenuSystem::filter_add_char, filter_remove_char and
+//! filter_clear. While the query isn't empty, next(), prev() and the other
+//! cursor moves of the MenuSystem only visit the components in the match
+//! list, in O(1) per move. Adding a character refines the match list in
+//! place, so only the components that still matched are looked at again;
+//! removing one scans the menu again.
+//!
+//! Renderers draw the matches with get_num_matches and get_match when
+//! is_active() returns true. The filter is cleared when the current menu
+//! changes, and isn't meant for a DataSourceMenu, whose components are a
+//! window of its items.
+//!
+//! \code
+//! StaticMenuFilter<32> filter;
+//! ms.set_filter(&filter);
+//!
+//! void on_key(char c) {
+//!     if (c == '\b')
+//!         ms.filter_remove_char();
+//!     else
+//!         ms.filter_add_char(c);
+//!     ms.display();
+//! }
+//! \endcode
+//!
+//! \see StaticMenuFilter
+class MenuFilter {
+    friend class MenuSystem;
+public:
+    //! \brief How names are compared with the query, combined as flags
+    enum Mode {
+        FILTER_PREFIX = 0x00,     //!< names start with the query
+        FILTER_SUBSTRING = 0x01,  //!< names contain the query
+        FILTER_MATCH_CASE = 0x02  //!< 'a' doesn't match 'A'
+    };
+
+    //! \brief Sets the Mode flags; clears the filter
+    void set_mode(uint8_t mode) { _mode = mode; end(); }
+    uint8_t get_mode() const { return _mode; }
+
+    //! \returns true while a query narrows the current menu.
+    bool is_active() const { return _p_menu != nullptr; }
+
+    //! \returns The menu being filtered, nullptr if none.
+    Menu const* get_menu() const { return _p_menu; }
+
+    //! \returns The query, "" when inactive.
+    const char* get_query() const { return _p_query; }
+
+    //! \returns The number of components matching the query.
+    menu_index_t get_num_matches() const { return _num_matches; }
+
+    //! \returns The index in the menu of the i-th match, in menu order.
+    menu_index_t get_match(menu_index_t i) const { return _p_matches[i]; }
+
+    //! \brief Returns true if the component at index matches the query
+    //!
+    //! Always true when inactive. O(log(number of matches)).
+    bool is_match(menu_index_t index) const {
+        if (!is_active())
+            return true;
+        menu_index_t position = lower_bound(index);
+        return position < _num_matches && _p_matches[position] == index;
+    }
+
+protected:
+    //! \param[in] p_matches An array of capacity indices.
+    //! \param[in] capacity The largest menu that can be filtered.
+    //! \param[in] p_query A buffer of query_size characters.
+    MenuFilter(menu_index_t* p_matches, menu_index_t capacity,
+               char* p_query, uint8_t query_size)
+    : _p_menu(nullptr),
+    _p_matches(p_matches),
+    _p_query(p_query),
+    _capacity(capacity),
+    _num_matches(0),
+    _position(0),
+    _query_size(query_size),
+    _query_length(0),
+    _mode(FILTER_PREFIX) {
+        _p_query[0] = '\0';
+    }
+
+private:
+    //! Starts filtering menu with an empty query
+    bool begin(Menu const& menu) {
+        if (menu.get_num_components() > _capacity)
+            return false;
+        _p_menu = &menu;
+        _num_matches = menu.get_num_components();
+        for (menu_index_t i = 0; i < _num_matches; ++i)
+            _p_matches[i] = i;
+        _position = 0;
+        return true;
+    }
+
+    void end() {
+        _p_menu = nullptr;
+        _num_matches = 0;
+        _query_length = 0;
+        _p_query[0] = '\0';
+    }
+
+    //! Adds c to the query and drops the matches that no longer match
+    bool add_char(char c) {
+        if (_query_length + 1 >= _query_size)
+            return false;
+        _p_query[_query_length++] = c;
+        _p_query[_query_length] = '\0';
+
+        menu_index_t num_matches = 0;
+        for (menu_index_t i = 0; i < _num_matches; ++i) {
+            const char* name = _p_menu->get_menu_component(_p_matches[i])->get_name();
+            bool match = (_mode & FILTER_SUBSTRING)
+                ? menu_name_matches(name, _p_query, _query_length, _mode)
+                // The name matched the shorter prefix: check the new character
+                : menu_name_matches(name + _query_length - 1, &c, 1, _mode);
+            if (match)
+                _p_matches[num_matches++] = _p_matches[i];
+        }
+        _num_matches = num_matches;
+        return true;
+    }
+
+    //! Removes the last character of the query and scans the menu again
+    bool remove_char() {
+        if (_query_length == 0)
+            return false;
+        _p_query[--_query_length] = '\0';
+
+        _num_matches = 0;
+        for (menu_index_t i = 0; i < _p_menu->get_num_components(); ++i) {
+            if (menu_name_matches(_p_menu->get_menu_component(i)->get_name(),
+                                  _p_query, _query_length, _mode))
+                _p_matches[_num_matches++] = i;
+        }
+        return true;
+    }
+
+    //! \returns The position of the first match at or after index.
+    menu_index_t lower_bound(menu_index_t index) const {
+        menu_index_t first = 0;
+        menu_index_t last = _num_matches;
+        while (first < last) {
+            menu_index_t middle = first + (last - first) / 2;
+            if (_p_matches[middle] < index)
+                first = middle + 1;
+            else
+                last = middle;
+        }
+        return first;
+    }
+
+    //! \returns The index of the first or last match; there must be one.
+    menu_index_t end_match(bool last) {
+        _position = last ? _num_matches - 1 : 0;
+        return _p_matches[_position];
+    }
+
+    //! \brief Finds the match delta matches away from the component at index
+    //!
+    //! From a component that doesn't match, the first match after it counts
+    //! as one step forward.
+    //!
+    //! \returns The index of the match, or index if there are no matches.
+    menu_index_t step(menu_index_t index, int16_t delta, bool loop) {
+        if (_num_matches == 0)
+            return index;
+
+        // Consecutive moves start from the cached position: O(1)
+        int32_t position = _position;
+        if (_position >= _num_matches || _p_matches[_position] != index) {
+            position = lower_bound(index);
+            if (position == _num_matches || _p_matches[position] != index) {
+                if (delta > 0)
+                    --delta;
+                else if (delta == 0 && position == _num_matches)
+                    position = 0;
+            }
+        }
+
+        position += delta;
+        if (loop) {
+            position %= _num_matches;
+            if (position < 0)
+                position += _num_matches;
+        } else if (position < 0) {
+            position = 0;
+        } else if (position >= _num_matches) {
+            position = _num_matches - 1;
+        }
+        _position = (menu_index_t) position;
+        return _p_matches[_position];
+    }
+
+private:
+    Menu const* _p_menu;
+    menu_index_t* _p_matches;
+    char* _p_query;
+    menu_index_t _capacity;
+    menu_index_t _num_matches;
+    menu_index_t _position;
+    uint8_t _query_size;
+    uint8_t _query_length;
+    uint8_t _mode;
+};
+
+//! \brief A MenuFilter for menus of up to N components, stored inline
+//!
+//! \tparam N The largest menu that can be filtered.
+//! \tparam QUERY_SIZE The size of the query buffer, including the '\0'.
+//!
+//! \see MenuFilter
+template <menu_index_t N, uint8_t QUERY_SIZE=16>
+class StaticMenuFilter : public MenuFilter {
+    static_assert(N > 0 && QUERY_SIZE > 1, "StaticMenuFilter needs room for a component and a character");
+public:
+    StaticMenuFilter() : MenuFilter(_matches, N, _query, QUERY_SIZE) {}
+
+private:
+    menu_index_t _matches[N];
+    char _query[QUERY_SIZE];
+};
+
+//! \brief Searches the whole tree below root for names matching query
+//!
+//! \param[in] query The text to look for.
+//! \param[in] mode A combination of MenuFilter::Mode flags.
+//! \param[out] p_results Receives the first size matches, depth first.
+//! \param[in] size The number of elements of p_results.
+//! \returns The number of matches, which may be larger than size.
+inline uint16_t menu_search(Menu const& root, const char* query, uint8_t mode,
+                            MenuComponent const** p_results, uint16_t size) {
+    uint16_t num_matches = 0;
+    uint8_t length = strlen(query);
+    for (menu_index_t i = 0; i < root.get_num_components(); ++i) {
+        MenuComponent const* p_component = root.get_menu_component(i);
+        if (menu_name_matches(p_component->get_name(), query, length, mode)) {
+            if (num_matches < size)
+                p_results[num_matches] = p_component;
+            ++num_matches;
+        }
+        if (p_component->get_type() == MenuComponent::TYPE_MENU) {
+            uint16_t offset = num_matches < size ? num_matches : size;
+            num_matches += menu_search(static_cast<Menu const&>(*p_component), query, mode,
+                                       p_results + offset, size - offset);
+        }
+    }
+    return num_matches;
+}
+
+//! \brief The menus from the root menu to the current menu
+//!
+//! Maintained by MenuSystem as menus are entered and left, so renderers can
+//! draw a "Root > Settings > Display" breadcrumb in O(1) per level instead
+//! of walking the parents every frame. Level 0 is the root menu, level
+//! get_depth() the current menu.
+//!
+//! \code
+//! void render(Menu const& menu) const {
+//!     MenuPath const& path = ms.get_path();
+//!     for (uint8_t level = 0; level <= path.get_depth(); ++level) {
+//!         Serial.print(path.get_menu(level)->get_name());
+//!         Serial.print(level < path.get_depth() ? " > " : "\n");
+//!     }
+//!     ...
+//! }
+//! \endcode
+//!
+//! \see MenuSystem::get_path
+class MenuPath {
+    friend class MenuSystem;
+public:
+    //! \returns The level of the current menu; 0 in the root menu.
+    uint8_t get_depth() const { return _depth; }
+
+    //! \returns The menu at level, nullptr if level is below the current
+    //!          menu.
+    Menu const* get_menu(uint8_t level) const { return menu_at(level); }
+
+    //! \brief Returns the index of the component that leads to level + 1
+    //!
+    //! That is the cursor of the menu at level when the next level was
+    //! entered; for the current menu, its cursor.
+    menu_index_t get_index(uint8_t level) const {
+        if (level < _depth && level < MENUSYSTEM_MAX_DEPTH)
+            return _indices[level];
+        Menu const* p_menu = menu_at(level);
+        return p_menu != nullptr ? p_menu->_current_component_num : 0;
+    }
+
+private:
+    MenuPath() : _p_top(nullptr), _depth(0) {}
+
+    Menu* menu_at(uint8_t level) const {
+        if (level > _depth)
+            return nullptr;
+        if (level < MENUSYSTEM_MAX_DEPTH)
+            return _menus[level];
+
+        Menu* p_menu = _p_top;
+        for (uint8_t i = _depth; i > level; --i)
+            p_menu = p_menu->_p_parent;
+        return p_menu;
+    }
+
+    //! Makes p_menu, a child of the current menu, the current menu
+    void push(Menu* p_menu) {
+        if (_depth < MENUSYSTEM_MAX_DEPTH)
+            _indices[_depth] = _p_top->_current_component_num;
+        ++_depth;
+        if (_depth < MENUSYSTEM_MAX_DEPTH)
+            _menus[_depth] = p_menu;
+        _p_top = p_menu;
+    }
+
+    //! Makes the menu at level the current menu
+    void pop(uint8_t level) {
+        _p_top = menu_at(level);
+        _depth = level;
+    }
+
+    //! Rebuilds the path to p_menu from its parents
+    void assign(Menu* p_menu) {
+        _depth = 0;
+        for (Menu* p = p_menu->_p_parent; p != nullptr; p = p->_p_parent)
+            ++_depth;
+        _p_top = p_menu;
+
+        uint8_t level = _depth;
+        for (Menu* p = p_menu; p != nullptr; p = p->_p_parent, --level) {
+            if (level < MENUSYSTEM_MAX_DEPTH) {
+                _menus[level] = p;
+                _indices[level] = p->_current_component_num;
+            }
+        }
+    }
+
+private:
+    Menu* _menus[MENUSYSTEM_MAX_DEPTH];
+    menu_index_t _indices[MENUSYSTEM_MAX_DEPTH];
+    Menu* _p_top;
+    uint8_t _depth;
+};
+
+//! \brief The part of the state of a MenuSystem that is kept in its tree
+//!
+//! The cursor and the focus of the current menu live in the components
+//! themselves. MenuSystem::save_cursor copies them out so another
+//! MenuSystem can navigate the same tree, MenuSystem::restore_cursor puts
+//! them back.
+//!
+//! \see MenuSession
+struct MenuCursor {
+    uint16_t position;           //!< see Menu::get_cursor_position
+    menu_index_t first_visible;  //!< see Menu::get_first_visible
+    bool has_focus;              //!< of the current component
+    uint8_t state_size;          //!< the bytes used in state
+    //! The edit state of the focused component, see
+    //! MenuComponent::save_cursor_state
+    uint8_t state[MENUSYSTEM_CURSOR_STATE_SIZE];
+};
 
 class MenuSystem {
 public:
-    MenuSystem(MenuComponentRenderer const& renderer, const char * name = "") : _p_root_menu(new Menu(name, nullptr)), _p_curr_menu(_p_root_menu), _renderer(renderer) {}
+    MenuSystem(MenuComponentRenderer const& renderer, const char * name = "") : _p_root_menu(new Menu(name, nullptr)), _p_curr_menu(_p_root_menu), _renderer(renderer), _owns_root_menu(true), _viewport_rows(0), _scroll_policy(Menu::SCROLL_EDGE), _p_filter(nullptr) { _path.assign(_p_root_menu); }
+
+    //! \brief Construct a MenuSystem around an existing root menu
+    //!
+    //! Allows the root menu to be a StaticMenu so no heap is used at all.
+    //!
+    //! \param[in] root_menu The root menu; must outlive the MenuSystem.
+    MenuSystem(MenuComponentRenderer const& renderer, Menu& root_menu) : _p_root_menu(&root_menu), _p_curr_menu(_p_root_menu), _renderer(renderer), _owns_root_menu(false), _viewport_rows(0), _scroll_policy(Menu::SCROLL_EDGE), _p_filter(nullptr) { _p_root_menu->enter(); _path.assign(_p_root_menu); }
 
+    ~MenuSystem() {
+        if (_owns_root_menu)
+            delete _p_root_menu;
+    }
+
+    //! \brief Renders the current menu
+    //!
+    //! Passes the changes recorded since the previous call to
+    //! MenuComponentRenderer::render_changes and clears them.
     void display() const {
-        if (_p_curr_menu != nullptr)
-            _renderer.render(*_p_curr_menu);
+        MENUSYSTEM_STAT_SCOPE(DISPLAY);
+        if (_p_curr_menu != nullptr) {
+            MENUSYSTEM_STAT_SCOPE(RENDER);
+            _renderer.render_changes(*_p_curr_menu, _changes);
+        }
+        _changes.clear();
     }
+
+    //! \brief Forces the next display() to redraw the whole menu
+    //!
+    //! Use it after the display was cleared or the state of a component was
+    //! changed outside of the MenuSystem, e.g. NumericMenuItem::set_value.
+    void invalidate() { _changes.mark_all(); }
+
+    //! \brief Records that the component at index changed outside of the
+    //!        MenuSystem
+    void invalidate(menu_index_t index) { _changes.mark(MenuChangeSet::CHANGE_VALUE, index); }
+
+    //! \returns The changes recorded since the last display().
+    MenuChangeSet const& get_changes() const { return _changes; }
+
+    //! \brief Sets the number of rows the display shows
+    //!
+    //! While the cursor moves, the MenuSystem keeps the current component
+    //! inside a window of rows components, see Menu::get_first_visible.
+    //! Renderers that only visit that window render in constant time
+    //! regardless of the size of the menu. A scroll is recorded as
+    //! MenuChangeSet::CHANGE_SCROLL.
+    //!
+    //! \param[in] rows The number of visible rows; 0 disables the viewport.
+    //! \param[in] policy A Menu::ScrollPolicy.
+    void set_viewport(uint8_t rows, uint8_t policy=Menu::SCROLL_EDGE) {
+        _viewport_rows = rows;
+        _scroll_policy = policy;
+        scrolled();
+        _changes.mark_all();
+    }
+
+    //! \returns The number of rows set with set_viewport, 0 if none.
+    uint8_t get_viewport_rows() const { return _viewport_rows; }
+
     bool next(bool loop=false) {
-        if (_p_curr_menu->_p_current_component->has_focus())
-            return _p_curr_menu->_p_current_component->next(loop);
-        else
-            return _p_curr_menu->next(loop);
+        MenuComponent* p_component = _p_curr_menu->_p_current_component;
+        if (p_component != nullptr && p_component->has_focus())
+            return changed_value(p_component->next(loop));
+
+        if (is_filtering())
+            return move_to_match(1, loop);
+        menu_index_t previous_num = _p_curr_menu->_current_component_num;
+        return moved_from(previous_num, _p_curr_menu->next(loop));
     }
     bool prev(bool loop=false) {
-        if (_p_curr_menu->_p_current_component->has_focus())
-            return _p_curr_menu->_p_current_component->prev(loop);
-        else
-            return _p_curr_menu->prev(loop);
+        MenuComponent* p_component = _p_curr_menu->_p_current_component;
+        if (p_component != nullptr && p_component->has_focus())
+            return changed_value(p_component->prev(loop));
+
+        if (is_filtering())
+            return move_to_match(-1, loop);
+        menu_index_t previous_num = _p_curr_menu->_current_component_num;
+        return moved_from(previous_num, _p_curr_menu->prev(loop));
+    }
+    //! \brief Moves by delta steps in a single transition
+    //!
+    //! Equivalent to |delta| calls to next() (or prev() for a negative delta)
+    //! but the change is recorded once. If the current component has focus
+    //! its value is stepped instead. While a filter is active, only the
+    //! matches count as steps.
+    //!
+    //! \returns true if the cursor or value changed, false otherwise.
+    bool move_by(int16_t delta, bool loop=false) {
+        MenuComponent* p_component = _p_curr_menu->_p_current_component;
+        if (p_component != nullptr && p_component->has_focus())
+            return changed_value(p_component->move_by(delta, loop));
+
+        if (is_filtering())
+            return move_to_match(delta, loop);
+        menu_index_t previous_num = _p_curr_menu->_current_component_num;
+        return moved_from(previous_num, _p_curr_menu->move_by(delta, loop));
+    }
+
+    //! \brief Makes the component at index of the current menu the current
+    //!        component
+    //!
+    //! \returns true if the cursor moved; false if index is out of range,
+    //!          already current, or the current component has focus.
+    bool move_to(menu_index_t index) {
+        MenuComponent* p_component = _p_curr_menu->_p_current_component;
+        if (p_component != nullptr && p_component->has_focus())
+            return false;
+
+        menu_index_t previous_num = _p_curr_menu->_current_component_num;
+        return moved_from(previous_num, _p_curr_menu->move_to(index));
     }
+
+    //! \brief Jumps to any component of the tree
+    //!
+    //! The component is given by its indices from the root menu: indices[0]
+    //! is the index of a component of the root menu, indices[1] the index of
+    //! a component of that component if it's a Menu, and so on. The menus
+    //! along the way are entered with their cursors on the next menu of the
+    //! path, and the last component becomes the current component, as if the
+    //! user had navigated there; back() then walks the path up.
+    //!
+    //! \param[in] indices The indices; nullptr if length is 0.
+    //! \param[in] length The number of indices; 0 jumps to the root menu.
+    //! \returns true on success; false if an index is out of range, a
+    //!          component before the last isn't a Menu or the current
+    //!          component has focus, in which case nothing changed.
+    //!
+    //! \see MenuIndex
+    bool jump_to(const menu_index_t* indices, uint8_t length) {
+        MenuComponent* p_component = _p_curr_menu->_p_current_component;
+        if (p_component != nullptr && p_component->has_focus())
+            return false;
+
+        Menu* p_menu = _p_root_menu;
+        for (uint8_t i = 0; i < length; ++i) {
+            if (indices[i] >= p_menu->_num_components)
+                return false;
+            if (i + 1 < length) {
+                p_component = p_menu->component_at(indices[i]);
+                if (p_component->get_type() != MenuComponent::TYPE_MENU)
+                    return false;
+                p_menu = static_cast<Menu*>(p_component);
+            }
+        }
+
+        p_menu = _p_root_menu;
+        _path.pop(0);
+        p_menu->apply_reset();
+        for (uint8_t i = 0; i < length; ++i) {
+            if (indices[i] != p_menu->_current_component_num)
+                p_menu->move_to(indices[i]);
+            if (i + 1 < length) {
+                p_menu = static_cast<Menu*>(p_menu->component_at(indices[i]));
+                _path.push(p_menu);
+                p_menu->enter();
+            }
+        }
+        _p_curr_menu = p_menu;
+        switched_menu();
+        return true;
+    }
+
+    //! \brief Jumps to the first component of the current menu
+    bool home() { return move_to_end(false); }
+
+    //! \brief Jumps to the last component of the current menu
+    bool end() { return move_to_end(true); }
+
+    //! \brief Moves rows components towards the first component
+    //! \param[in] rows The page size; 0 uses the viewport rows.
+    bool page_up(uint8_t rows=0, bool loop=false) { return move_by(-(int16_t) page_size(rows), loop); }
+
+    //! \brief Moves rows components towards the last component
+    //! \param[in] rows The page size; 0 uses the viewport rows.
+    bool page_down(uint8_t rows=0, bool loop=false) { return move_by(page_size(rows), loop); }
+
+    //! \brief Goes back to the root menu and resets the tree
+    //!
+    //! Takes time in the number of components of the root menu, not of the
+    //! tree: the sub menus are reset when they are entered next, see
+    //! Menu::reset.
     void reset() {
         _p_curr_menu = _p_root_menu;
+        _path.pop(0);
         _p_root_menu->reset();
+        _p_root_menu->apply_reset();
+        switched_menu();
     }
     void select(bool reset=false) {
+        MENUSYSTEM_STAT_SCOPE(SELECT);
+        Menu* p_menu = _p_curr_menu;
+        MenuComponent const* p_component = p_menu->get_current_component();
+        bool had_focus = p_component != nullptr && p_component->has_focus();
         Menu* pMenu = _p_curr_menu->activate();
 
-        if (pMenu != nullptr)
+        if (pMenu != nullptr) {
+            // Usually a child; a select function may return any menu
+            if (pMenu->_p_parent == _p_curr_menu)
+                _path.push(pMenu);
+            else
+                _path.assign(pMenu);
             _p_curr_menu = pMenu;
-        else
-            if (reset)
-                this->reset();
-    }
-    bool back() {
-        if (_p_curr_menu != _p_root_menu) {
-            _p_curr_menu = const_cast<Menu*>(_p_curr_menu->get_parent());
-            return true;
+            _p_curr_menu->enter();
+            switched_menu();
+        } else if (p_component != nullptr && is_unbound_back_item(*p_component)) {
+            back();
+        } else if (reset) {
+            this->reset();
+        } else if (_p_curr_menu == p_menu && p_component != nullptr) {
+            // The selected component may have toggled its focus or its value
+            uint8_t flags = MenuChangeSet::CHANGE_VALUE;
+            if (p_component->has_focus() != had_focus)
+                flags |= MenuChangeSet::CHANGE_FOCUS;
+            _changes.mark(flags, p_menu->_current_component_num);
         }
+    }
+    //! \brief Goes up levels menus
+    //!
+    //! The cursor of the menu returned to is put back on the component that
+    //! was selected to leave it.
+    //!
+    //! \param[in] levels The number of levels to go up; going up more levels
+    //!                   than the depth of the current menu stops at the root
+    //!                   menu.
+    //! \returns true if the current menu changed, false if it already was the
+    //!          root menu.
+    bool back(uint8_t levels=1) {
+        uint8_t depth = _path.get_depth();
+        if (depth == 0 || levels == 0)
+            return false;
 
-        // We are already in the root menu
-        return false;
+        uint8_t level = levels < depth ? depth - levels : 0;
+        menu_index_t index = _path.get_index(level);
+        _path.pop(level);
+        _p_curr_menu = _path.menu_at(level);
+        _p_curr_menu->apply_reset();
+        if (index != _p_curr_menu->_current_component_num)
+            _p_curr_menu->move_to(index);
+        switched_menu();
+        return true;
     }
 
     Menu& get_root_menu() const { return *_p_root_menu; }
     Menu const* get_current_menu() const { return _p_curr_menu; }
 
+    //! \returns The menus from the root menu to the current menu.
+    MenuPath const& get_path() const { return _path; }
+
+    //! \brief Copies the cursor of the current menu out of the tree
+    //!
+    //! The focus is taken from the current component, together with its edit
+    //! state, see MenuComponent::save_cursor_state, so the tree can be
+    //! navigated by another MenuSystem built on the same root menu until
+    //! restore_cursor is called. The rest of the state of a MenuSystem, its
+    //! path, filter, viewport and changes, is its own.
+    //!
+    //! \see MenuSession
+    void save_cursor(MenuCursor& cursor) {
+        MenuComponent* p_component = _p_curr_menu->_p_current_component;
+        cursor.position = _p_curr_menu->get_cursor_position();
+        cursor.first_visible = _p_curr_menu->_first_visible;
+        cursor.has_focus = p_component != nullptr && p_component->_has_focus;
+        cursor.state_size = 0;
+        if (cursor.has_focus) {
+            cursor.state_size = p_component->save_cursor_state(cursor.state, sizeof(cursor.state));
+            p_component->_has_focus = false;
+        }
+    }
+
+    //! \brief Puts back a cursor copied by save_cursor
+    //!
+    //! Applies the resets made since, by any MenuSystem, to the menus of the
+    //! path first. If the cursor can't be restored as it was, e.g. because
+    //! the menu shrank or the component rejected its edit state, the focus
+    //! isn't restored and the next display() redraws the whole menu.
+    void restore_cursor(MenuCursor const& cursor) {
+        _p_curr_menu->apply_resets();
+        MenuComponent* p_component = _p_curr_menu->_p_current_component;
+        if (p_component != nullptr)
+            p_component->_has_focus = false;
+
+        bool restored = _p_curr_menu->set_cursor_position(cursor.position);
+        if (cursor.first_visible < _p_curr_menu->_num_components)
+            _p_curr_menu->_first_visible = cursor.first_visible;
+        if (_p_curr_menu->scroll_to_current(_viewport_rows, _scroll_policy)
+            || _p_curr_menu->_first_visible != cursor.first_visible)
+            restored = false;
+
+        p_component = _p_curr_menu->_p_current_component;
+        if (restored && cursor.has_focus && p_component != nullptr)
+            restored = p_component->load_cursor_state(cursor.state, cursor.state_size);
+        if (restored && cursor.has_focus && p_component != nullptr)
+            p_component->_has_focus = true;
+        if (!restored)
+            _changes.mark_all();
+    }
+
+    //! \brief Sets the filter used by the filter_* functions
+    //! \param[in] p_filter The filter, nullptr to disable type-ahead.
+    void set_filter(MenuFilter* p_filter) {
+        if (is_filtering())
+            _changes.mark_all(MenuChangeSet::CHANGE_FILTER);
+        _p_filter = p_filter;
+        if (_p_filter != nullptr)
+            _p_filter->end();
+    }
+
+    //! \returns The filter set with set_filter, nullptr if none.
+    MenuFilter const* get_filter() const { return _p_filter; }
+
+    //! \brief Appends c to the query of the filter of the current menu
+    //!
+    //! The first character starts filtering the current menu. If the current
+    //! component doesn't match anymore, the cursor moves to the next match,
+    //! wrapping around. The change is recorded as
+    //! MenuChangeSet::CHANGE_FILTER; leaving the menu clears the filter.
+    //!
+    //! \returns true if any component matches; false if none does, no
+    //!          filter is set, the query is full, the menu is larger than
+    //!          the filter or the current component has focus.
+    bool filter_add_char(char c) {
+        MenuComponent* p_component = _p_curr_menu->_p_current_component;
+        if (_p_filter == nullptr || (p_component != nullptr && p_component->has_focus()))
+            return false;
+        if (!_p_filter->is_active() && !_p_filter->begin(*_p_curr_menu))
+            return false;
+        if (!_p_filter->add_char(c))
+            return false;
+
+        filtered();
+        return _p_filter->get_num_matches() != 0;
+    }
+
+    //! \brief Removes the last character of the query
+    //!
+    //! Removing the last character clears the filter.
+    //!
+    //! \returns true if the query changed, false if there's no query.
+    bool filter_remove_char() {
+        if (!is_filtering() || !_p_filter->remove_char())
+            return false;
+        if (_p_filter->get_query()[0] == '\0')
+            _p_filter->end();
+
+        filtered();
+        return true;
+    }
+
+    //! \brief Clears the query, showing all components again
+    //! \returns true if a query was cleared.
+    bool filter_clear() {
+        if (!is_filtering())
+            return false;
+        _p_filter->end();
+        _changes.mark_all(MenuChangeSet::CHANGE_FILTER);
+        return true;
+    }
+
+private:
+    bool changed_value(bool changed) {
+        if (changed)
+            _changes.mark(MenuChangeSet::CHANGE_VALUE, _p_curr_menu->_current_component_num);
+        return changed;
+    }
+
+    bool moved_from(menu_index_t previous_num, bool moved) {
+        if (moved) {
+            _changes.mark(MenuChangeSet::CHANGE_CURSOR, previous_num);
+            _changes.mark(MenuChangeSet::CHANGE_CURSOR, _p_curr_menu->_current_component_num);
+            scrolled();
+        }
+        return moved;
+    }
+
+    void switched_menu() {
+        if (_p_filter != nullptr)
+            _p_filter->end();
+        _p_curr_menu->scroll_to_current(_viewport_rows, _scroll_policy);
+        _changes.mark_all(MenuChangeSet::CHANGE_MENU);
+    }
+
+    static bool is_unbound_back_item(MenuComponent const& component);
+
+    void scrolled() {
+        if (_p_curr_menu->scroll_to_current(_viewport_rows, _scroll_policy))
+            _changes.mark_all(MenuChangeSet::CHANGE_SCROLL);
+    }
+
+    bool move_to_end(bool last) {
+        MenuComponent* p_component = _p_curr_menu->_p_current_component;
+        if (p_component != nullptr && p_component->has_focus())
+            return false;
+
+        menu_index_t previous_num = _p_curr_menu->_current_component_num;
+        if (is_filtering()) {
+            if (_p_filter->get_num_matches() == 0)
+                return false;
+            return moved_from(previous_num, _p_curr_menu->move_to(_p_filter->end_match(last)));
+        }
+        return moved_from(previous_num, _p_curr_menu->move_to_end(last));
+    }
+
+    bool is_filtering() const {
+        return _p_filter != nullptr && _p_filter->get_menu() == _p_curr_menu;
+    }
+
+    bool move_to_match(int16_t delta, bool loop) {
+        menu_index_t previous_num = _p_curr_menu->_current_component_num;
+        menu_index_t index = _p_filter->step(previous_num, delta, loop);
+        return moved_from(previous_num, index != previous_num && _p_curr_menu->move_to(index));
+    }
+
+    //! Keeps the cursor on a match after the query changed
+    void filtered() {
+        menu_index_t current_num = _p_curr_menu->_current_component_num;
+        if (_p_filter->is_active() && !_p_filter->is_match(current_num))
+            move_to_match(0, true);
+        _changes.mark_all(MenuChangeSet::CHANGE_FILTER);
+    }
+
+    uint8_t page_size(uint8_t rows) const {
+        if (rows != 0)
+            return rows;
+        return _viewport_rows != 0 ? _viewport_rows : 1;
+    }
+
+    // A copy would delete the root menu it owns twice
+    MenuSystem(MenuSystem const&);
+    MenuSystem& operator=(MenuSystem const&);
+
 private:
     Menu* _p_root_menu;
     Menu* _p_curr_menu;
     MenuComponentRenderer const& _renderer;
+    // Consumed by display(), which is const for backwards compatibility
+    mutable MenuChangeSet _changes;
+    bool _owns_root_menu;
+    uint8_t _viewport_rows;
+    uint8_t _scroll_policy;
+    MenuPath _path;
+    MenuFilter* _p_filter;
 };
 
 //! \brief A MenuItem that calls MenuSystem::back() when selected.
 //! \see MenuItem
 class BackMenuItem : public MenuItem {
 public:
-    BackMenuItem(const char* name, SelectFnPtr select_fn, MenuSystem* ms) : MenuItem(name, select_fn), _menu_system(ms) {}
+    constexpr BackMenuItem(const char* name, SelectFnPtr select_fn, MenuSystem* ms) : MenuItem(name, select_fn, TYPE_BACK_MENU_ITEM), _menu_system(ms) {}
 
     virtual void render(MenuComponentRenderer const& renderer) const { renderer.render_back_menu_item(*this); }
 
@@ -482,10 +2180,13 @@ public:
       return false;
     }
 
+    //! \returns The MenuSystem the item goes back in; nullptr for the one
+    //!          that selects it.
+    MenuSystem* get_menu_system() const { return _menu_system; }
+
 protected:
     virtual Menu* select() {
-        if (_select_fn!=nullptr)
-            _select_fn(this);
+        call_select_fn();
 
         if (_menu_system!=nullptr)
             _menu_system->back();
@@ -497,6 +2198,13 @@ protected:
     MenuSystem* _menu_system;
 };
 
+//! A BackMenuItem without a MenuSystem goes back in the MenuSystem that
+//! selects it, so it works in trees shared by several MenuSystems
+inline bool MenuSystem::is_unbound_back_item(MenuComponent const& component) {
+    return component.get_type() == MenuComponent::TYPE_BACK_MENU_ITEM
+        && static_cast<BackMenuItem const&>(component).get_menu_system() == nullptr;
+}
+
 class NumericMenuItem : public MenuItem {
 public:
     //! \brief Callback for formatting the numeric value into a String.
@@ -520,12 +2228,13 @@ public:
                     float value, float min_value, float max_value,
                     float increment=1.0,
                     FormatValueFnPtr format_value_fn=nullptr)
-        : MenuItem(basename, select_fn),
+        : MenuItem(basename, select_fn, TYPE_NUMERIC_MENU_ITEM),
         _value(value),
         _min_value(min_value),
         _max_value(max_value),
         _increment(increment),
-        _format_value_fn(format_value_fn)
+        _format_value_fn(format_value_fn),
+        _format_value_buffer_fn(nullptr)
     {
         if (_increment < 0.0) _increment = -_increment;
         if (_min_value > _max_value) {
@@ -543,6 +2252,14 @@ public:
     //!
     void set_number_formatter(FormatValueFnPtr format_value_fn) { _format_value_fn = format_value_fn; }
 
+    //! \brief Sets a formatter that writes into a caller supplied buffer
+    //!
+    //! Takes precedence over the String formatter and keeps format_value
+    //! free of heap allocations.
+    //!
+    //! \param format_value_buffer_fn The formatter, or nullptr.
+    void set_value_formatter(FormatValueBufferFnPtr format_value_buffer_fn) { _format_value_buffer_fn = format_value_buffer_fn; }
+
     float get_value() const { return _value; }
     float get_min_value() const { return _min_value; }
     float get_max_value() const { return _max_value; }
@@ -551,13 +2268,23 @@ public:
     void set_min_value(float value) { _min_value = value; }
     void set_max_value(float value) { _max_value = value; }
 
+    //! \brief Writes the formatted value into buffer
+    //!
+    //! Doesn't use the heap unless only a String formatter is set.
+    //!
+    //! \param[out] buffer The buffer to write the 0-terminated text to.
+    //! \param[in] size The size of buffer in bytes.
+    //! \returns The length of the text written.
+    size_t format_value(char* buffer, size_t size) const {
+        return menu_format_value(_value, buffer, size, _format_value_fn, _format_value_buffer_fn);
+    }
+
     String get_formatted_value() const {
-        String buffer;
-        if (_format_value_fn != nullptr)
-            buffer += _format_value_fn(_value);
-        else
-            buffer += _value;
-        return buffer;
+        if (_format_value_fn != nullptr && _format_value_buffer_fn == nullptr)
+            return _format_value_fn(_value);
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        format_value(buffer, sizeof(buffer));
+        return String(buffer);
     }
 
     virtual void render(MenuComponentRenderer const& renderer) const { renderer.render_numeric_menu_item(*this); }
@@ -565,6 +2292,28 @@ public:
     virtual bool has_children() const {
       return false;
     }
+
+    //! \copydoc MenuComponent::save_state
+    virtual uint8_t save_state(uint8_t* buffer, uint8_t size) const {
+        if (size < sizeof(_value))
+            return 0;
+        memcpy(buffer, &_value, sizeof(_value));
+        return sizeof(_value);
+    }
+
+    //! \copydoc MenuComponent::load_state
+    //!
+    //! Values outside of the range of the item are rejected.
+    virtual bool load_state(const uint8_t* buffer, uint8_t size) {
+        float value;
+        if (size != sizeof(value))
+            return false;
+        memcpy(&value, buffer, sizeof(value));
+        if (!(value >= _min_value && value <= _max_value))
+            return false;
+        _value = value;
+        return true;
+    }
 protected:
     virtual bool next(bool loop=false) {
         _value += _increment;
@@ -587,12 +2336,29 @@ protected:
         return true;
     }
 
+    //! \copydoc MenuComponent::move_by
+    //!
+    //! Takes O(1) unless the value wraps around.
+    virtual bool move_by(int16_t delta, bool loop=false) {
+        if (delta == 0)
+            return false;
+
+        float value = _value + delta * _increment;
+        if (value >= _min_value && value <= _max_value)
+            _value = value;
+        else if (!loop)
+            _value = value > _max_value ? _max_value : _min_value;
+        else
+            return MenuItem::move_by(delta, loop);
+        return true;
+    }
+
     virtual Menu* select() {
         _has_focus = !_has_focus;
 
         // Only run _select_fn when the user is done editing the value
-        if (!_has_focus && _select_fn != nullptr)
-            _select_fn(this);
+        if (!_has_focus)
+            call_select_fn();
         return nullptr;
     }
 
@@ -602,7 +2368,144 @@ protected:
     float _max_value;
     float _increment;
     FormatValueFnPtr _format_value_fn;
+    FormatValueBufferFnPtr _format_value_buffer_fn;
 };
 
+//! \brief Common base of the numeric items with a templated value type
+//!
+//! Renderers see every NumericMenuItemT instantiation through this class,
+//! see MenuComponentRenderer::render_numeric_value_menu_item. Like
+//! NumericMenuItem, selecting it toggles focus so next and prev change the
+//! value.
+//!
+//! \see NumericMenuItemT
+class NumericValueMenuItem : public MenuItem {
+public:
+    constexpr NumericValueMenuItem(const char* name, SelectFnPtr select_fn)
+    : MenuItem(name, select_fn, TYPE_NUMERIC_VALUE_MENU_ITEM) {
+    }
+
+    //! \brief Writes the formatted value into buffer
+    //!
+    //! \param[out] buffer The buffer to write the 0-terminated text to.
+    //! \param[in] size The size of buffer in bytes.
+    //! \returns The length of the text written.
+    virtual size_t format_value(char* buffer, size_t size) const = 0;
+
+    //! \brief Returns the position of the value within its range
+    //!
+    //! Useful to draw bar graphs without knowing the value type.
+    //!
+    //! \param[in] scale The position of the maximum value.
+    //! \returns 0 for the minimum value up to scale for the maximum value.
+    virtual uint8_t get_value_position(uint8_t scale) const = 0;
+
+    virtual void render(MenuComponentRenderer const& renderer) const { renderer.render_numeric_value_menu_item(*this); }
+
+protected:
+    virtual Menu* select() {
+        _has_focus = !_has_focus;
+
+        // Only run _select_fn when the user is done editing the value
+        if (!_has_focus)
+            call_select_fn();
+        return nullptr;
+    }
+};
+
+inline void MenuComponentRenderer::render_numeric_value_menu_item(NumericValueMenuItem const& menu_item) const {
+    render_menu_item(menu_item);
+}
+
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+
+class CiutNullRenderer : public MenuComponentRenderer {
+public:
+    void render(Menu const& menu) const {}
+    void render_menu_item(MenuItem const& menu_item) const {}
+    void render_back_menu_item(BackMenuItem const& menu_item) const {}
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {}
+    void render_menu(Menu const& menu) const {}
+};
+
+TEST_CASE( .name="menusystem-reset", .description="Lazy reset of the menu tree.", .skip=0 ) {
+    CiutNullRenderer renderer;
+    MenuSystem ms(renderer, "root");
+    Menu mu1("mu1");
+    Menu mu_empty("empty");
+    MenuItem mm_mi1("mm_mi1", nullptr);
+    MenuItem mu1_mi1("mu1_mi1", nullptr);
+    MenuItem mu1_mi2("mu1_mi2", nullptr);
+    NumericMenuItem mu1_mi3("mu1_mi3", nullptr, 0, 0, 10);
+    ms.get_root_menu().add_menu(&mu1);
+    ms.get_root_menu().add_item(&mm_mi1);
+    ms.get_root_menu().add_menu(&mu_empty);
+    mu1.add_item(&mu1_mi1);
+    mu1.add_item(&mu1_mi2);
+    mu1.add_item(&mu1_mi3);
+
+    SECTION("select(true) resets the cursor and the focus of the sub menus") {
+        ms.select();
+        ms.next();
+        ms.next();
+        ms.select();
+        REQUIRE(mu1_mi3.has_focus());
+        ms.select();
+        ms.prev();
+        ms.select(true);
+        REQUIRE(ms.get_current_menu() == &ms.get_root_menu());
+        REQUIRE(mu1.is_reset_pending());
+
+        REQUIRE(!ms.back());
+        ms.select();
+        REQUIRE(ms.get_current_menu() == &mu1);
+        REQUIRE(!mu1.is_reset_pending());
+        REQUIRE(mu1.get_current_component_num() == 0);
+        REQUIRE(mu1.get_current_component() == &mu1_mi1);
+        REQUIRE(mu1_mi1.is_current());
+        REQUIRE(!mu1_mi2.is_current());
+        REQUIRE(!mu1_mi3.is_current());
+        REQUIRE(!mu1_mi3.has_focus());
+    }
+
+    SECTION("a menu without components can be reset") {
+        MenuSystem ms_none(renderer, "none");
+        ms_none.reset();
+        ms_none.select(true);
+        REQUIRE(ms_none.get_current_menu()->get_current_component() == nullptr);
+
+        ms.reset();
+        ms.end();
+        ms.select();
+        REQUIRE(ms.get_current_menu() == &mu_empty);
+        ms.reset();
+        ms.end();
+        ms.select();
+        REQUIRE(ms.get_current_menu() == &mu_empty);
+        REQUIRE(mu_empty.get_current_component() == nullptr);
+        ms.reset();
+    }
+
+    SECTION("save_state reports the cursor after the pending reset") {
+        ms.reset();
+        ms.select();
+        ms.next();
+        ms.back();
+        REQUIRE(mu1.get_current_component_num() == 1);
+
+        uint8_t buffer[sizeof(menu_index_t)];
+        REQUIRE(mu1.save_state(buffer, sizeof(buffer)) == sizeof(menu_index_t));
+        REQUIRE(buffer[0] == 1);
+
+        ms.reset();
+        REQUIRE(mu1.get_current_component_num() == 1);
+        REQUIRE(mu1.save_state(buffer, sizeof(buffer)) == sizeof(menu_index_t));
+        for (uint8_t i = 0; i < sizeof(buffer); ++i)
+            REQUIRE(buffer[i] == 0);
+    }
+}
+
+#endif // CIUT_ENABLED
 
 #endif
@@ -0,0 +1,518 @@
+/**
+ * \file    MenuTrace.h
+ * \brief   MenuRecorder and MenuTraceRenderer, record a session into a
+ *          binary trace; MenuTracePlayer replays it
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef MENU_TRACE_H
+#define MENU_TRACE_H
+
+#include "MenuSystem.h"
+#include "MenuComponentRenderer2.h"
+#include "NumericDisplayMenuItem.h"
+#include "TextEditMenuItem.h"
+#include "ToggleMenuItem.h"
+
+#if !defined(ARDUINO)
+#include <stdio.h>
+#endif
+
+//! \brief The records of a trace
+//!
+//! A trace starts with the 4 byte header 'M', 'T', TRACE_VERSION, 0 and
+//! continues with records of an opcode byte, whose TRACE_FLAG bit holds the
+//! loop or reset argument, and the operands of the opcode, little endian.
+enum MenuTraceOp {
+    TRACE_NEXT = 0x01,    //!< MenuSystem::next
+    TRACE_PREV = 0x02,    //!< MenuSystem::prev
+    TRACE_MOVE_BY = 0x03, //!< MenuSystem::move_by; int16 delta
+    TRACE_MOVE_TO = 0x04, //!< MenuSystem::move_to; uint16 index
+    TRACE_HOME = 0x05,    //!< MenuSystem::home
+    TRACE_END = 0x06,     //!< MenuSystem::end
+    TRACE_SELECT = 0x07,  //!< MenuSystem::select
+    TRACE_BACK = 0x08,    //!< MenuSystem::back; uint8 levels
+    TRACE_RESET = 0x09,   //!< MenuSystem::reset
+    TRACE_JUMP = 0x0a,    //!< MenuSystem::jump_to; uint8 length, uint16 indices
+    TRACE_DISPLAY = 0x0b, //!< MenuSystem::display
+    TRACE_FRAME = 0x0c,   //!< A frame was rendered; uint32 digest
+    TRACE_FLAG = 0x80,    //!< loop for next, prev and move_by; reset for select
+    TRACE_VERSION = 1
+};
+
+//! \brief Where a trace is written to: a file, a serial port, a buffer...
+//!
+//! \code
+//! class SerialTraceWriter : public MenuTraceWriter {
+//! public:
+//!     bool write(const uint8_t* data, uint8_t size) { return Serial.write(data, size) == size; }
+//! };
+//! \endcode
+class MenuTraceWriter {
+public:
+    //! \returns true if size bytes were written.
+    virtual bool write(const uint8_t* data, uint8_t size) = 0;
+
+    virtual ~MenuTraceWriter() {}
+};
+
+//! \brief Where a trace is read from
+class MenuTraceReader {
+public:
+    //! \returns true if size bytes were read, false at the end of the trace.
+    virtual bool read(uint8_t* data, uint8_t size) = 0;
+
+    virtual ~MenuTraceReader() {}
+};
+
+#if !defined(ARDUINO)
+//! \brief A MenuTraceWriter and MenuTraceReader on a file, for host builds
+class MenuTraceFile : public MenuTraceWriter, public MenuTraceReader {
+public:
+    //! \param[in] mode "wb" to record, "rb" to replay.
+    MenuTraceFile(const char* path, const char* mode) : _p_file(fopen(path, mode)) {}
+
+    ~MenuTraceFile() {
+        if (_p_file != nullptr)
+            fclose(_p_file);
+    }
+
+    bool is_open() const { return _p_file != nullptr; }
+
+    bool write(const uint8_t* data, uint8_t size) {
+        return _p_file != nullptr && fwrite(data, 1, size, _p_file) == size;
+    }
+
+    bool read(uint8_t* data, uint8_t size) {
+        return _p_file != nullptr && fread(data, 1, size, _p_file) == size;
+    }
+
+private:
+    MenuTraceFile(MenuTraceFile const&);
+    MenuTraceFile& operator=(MenuTraceFile const&);
+
+    FILE* _p_file;
+};
+#endif
+
+//! \brief Writes the records of a trace
+class MenuTraceEncoder {
+public:
+    explicit MenuTraceEncoder(MenuTraceWriter& writer) : _writer(writer), _num_failed(0) {}
+
+    //! \brief Writes the header of the trace
+    void write_header() {
+        const uint8_t header[] = { 'M', 'T', TRACE_VERSION, 0 };
+        write(header, sizeof(header));
+    }
+
+    void write_op(uint8_t op) { write(&op, 1); }
+
+    void write_op8(uint8_t op, uint8_t operand) {
+        const uint8_t record[] = { op, operand };
+        write(record, sizeof(record));
+    }
+
+    void write_op16(uint8_t op, uint16_t operand) {
+        const uint8_t record[] = { op, (uint8_t) operand, (uint8_t) (operand >> 8) };
+        write(record, sizeof(record));
+    }
+
+    void write_frame(uint32_t digest) {
+        const uint8_t record[] = {
+            TRACE_FRAME, (uint8_t) digest, (uint8_t) (digest >> 8),
+            (uint8_t) (digest >> 16), (uint8_t) (digest >> 24)
+        };
+        write(record, sizeof(record));
+    }
+
+    void write_jump(const menu_index_t* indices, uint8_t length) {
+        const uint8_t record[] = { TRACE_JUMP, length };
+        write(record, sizeof(record));
+        for (uint8_t i = 0; i < length; ++i) {
+            const uint8_t index[] = { (uint8_t) indices[i], (uint8_t) (indices[i] >> 8) };
+            write(index, sizeof(index));
+        }
+    }
+
+    //! \returns The number of records that couldn't be written.
+    uint16_t get_num_failed() const { return _num_failed; }
+
+private:
+    void write(const uint8_t* data, uint8_t size) {
+        if (!_writer.write(data, size) && _num_failed != UINT16_MAX)
+            _num_failed++;
+    }
+
+private:
+    MenuTraceWriter& _writer;
+    uint16_t _num_failed;
+};
+
+//! \brief A MenuComponentRenderer that records a digest of each frame and
+//!        forwards the rendering to another renderer
+//!
+//! The digest covers what a renderer can show of the current menu: its
+//! name, the viewport, and the type, name, current and focus flags and
+//! value of every component. Two runs that render the same frames produce
+//! the same digests, whatever the renderer draws with them.
+//!
+//! \code
+//! MyRenderer my_renderer;
+//! MenuTraceRenderer trace_renderer(my_renderer, &encoder);
+//! MenuSystem ms(trace_renderer);
+//! \endcode
+//!
+//! \see MenuRecorder
+class MenuTraceRenderer : public MenuComponentRenderer2 {
+public:
+    //! \param[in] renderer The renderer that draws the frames.
+    //! \param[in] p_encoder Receives a TRACE_FRAME record per frame; nullptr
+    //!                      to only compute the digests, see get_digest.
+    explicit MenuTraceRenderer(MenuComponentRenderer const& renderer,
+                               MenuTraceEncoder* p_encoder=nullptr)
+    : _renderer(renderer),
+    _p_encoder(p_encoder),
+    _digest(0),
+    _num_frames(0) {
+    }
+
+    //! \brief Sets the encoder that receives the TRACE_FRAME records
+    void set_encoder(MenuTraceEncoder* p_encoder) { _p_encoder = p_encoder; }
+
+    //! \returns The digest of the last frame.
+    uint32_t get_digest() const { return _digest; }
+
+    //! \returns The number of frames rendered.
+    uint32_t get_num_frames() const { return _num_frames; }
+
+    void render(Menu const& menu) const {
+        record(menu);
+        _renderer.render(menu);
+    }
+
+    void render_changes(Menu const& menu, MenuChangeSet const& changes) const {
+        record(menu);
+        _renderer.render_changes(menu, changes);
+    }
+
+    void render_menu_item(MenuItem const& menu_item) const { add_component(menu_item, nullptr); }
+    void render_back_menu_item(BackMenuItem const& menu_item) const { add_component(menu_item, nullptr); }
+
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        menu_item.format_value(buffer, sizeof(buffer));
+        add_component(menu_item, buffer);
+    }
+
+    void render_numeric_value_menu_item(NumericValueMenuItem const& menu_item) const {
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        menu_item.format_value(buffer, sizeof(buffer));
+        add_component(menu_item, buffer);
+    }
+
+    void render_toggle_menu_item(ToggleMenuItem const& menu_item) const {
+        add_component(menu_item, menu_item.get_state_str());
+    }
+
+    void render_numeric_display_menu_item(NumericDisplayMenuItem const& menu_item) const {
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        menu_item.format_value(buffer, sizeof(buffer));
+        add_component(menu_item, buffer);
+    }
+
+    void render_text_edit_menu_item(TextEditMenuItem const& menu_item) const {
+        add_component(menu_item, menu_item.get_value());
+        add_byte(menu_item.get_pos());
+        add_byte(menu_item.get_edit_state());
+    }
+
+    void render_menu(Menu const& menu) const { add_component(menu, nullptr); }
+
+private:
+    //! Computes the digest of the frame and records it
+    void record(Menu const& menu) const {
+        _digest = FNV_OFFSET_BASIS;
+        add_string(menu.get_name());
+        add_byte(menu.get_first_visible());
+        add_byte(menu.get_current_component_num());
+        for (menu_index_t i = 0; i < menu.get_num_components(); ++i)
+            menu.get_menu_component(i)->render(*this);
+
+        _num_frames++;
+        if (_p_encoder != nullptr)
+            _p_encoder->write_frame(_digest);
+    }
+
+    void add_component(MenuComponent const& component, const char* value) const {
+        add_byte(component.get_type());
+        add_byte((component.is_current() ? 1 : 0) | (component.has_focus() ? 2 : 0));
+        add_string(component.get_name());
+        add_string(value != nullptr ? value : "");
+    }
+
+    void add_string(const char* text) const {
+        for (; *text != '\0'; ++text)
+            add_byte(*text);
+        add_byte(0);
+    }
+
+    void add_byte(uint8_t byte) const { _digest = (_digest ^ byte) * 16777619UL; }
+
+private:
+    static const uint32_t FNV_OFFSET_BASIS = 0x811c9dc5UL;
+
+    MenuComponentRenderer const& _renderer;
+    MenuTraceEncoder* _p_encoder;
+    mutable uint32_t _digest;
+    mutable uint32_t _num_frames;
+};
+
+//! \brief Records the navigation calls of a MenuSystem into a trace
+//!
+//! Call the navigation functions of the recorder instead of those of the
+//! MenuSystem; each call is recorded and passed on. With a
+//! MenuTraceRenderer sharing the encoder, the trace also holds a digest of
+//! every frame, so MenuTracePlayer can check that a replay renders the same
+//! frames. Together they turn a field report into a reproducible trace.
+//! Frames must be rendered through display() of the recorder, so the replay
+//! renders them at the same point.
+//!
+//! \code
+//! MenuTraceFile file("session.trace", "wb");
+//! MenuTraceEncoder encoder(file);
+//! MenuTraceRenderer trace_renderer(my_renderer, &encoder);
+//! MenuSystem ms(trace_renderer);
+//! MenuRecorder recorder(ms, encoder);
+//!
+//! recorder.next();
+//! recorder.select();
+//! recorder.display();
+//! \endcode
+//!
+//! \see MenuTracePlayer
+class MenuRecorder {
+public:
+    //! \brief Writes the header of the trace
+    MenuRecorder(MenuSystem& ms, MenuTraceEncoder& encoder) : _ms(ms), _encoder(encoder) {
+        _encoder.write_header();
+    }
+
+    bool next(bool loop=false) {
+        _encoder.write_op(TRACE_NEXT | (loop ? TRACE_FLAG : 0));
+        return _ms.next(loop);
+    }
+
+    bool prev(bool loop=false) {
+        _encoder.write_op(TRACE_PREV | (loop ? TRACE_FLAG : 0));
+        return _ms.prev(loop);
+    }
+
+    bool move_by(int16_t delta, bool loop=false) {
+        _encoder.write_op16(TRACE_MOVE_BY | (loop ? TRACE_FLAG : 0), (uint16_t) delta);
+        return _ms.move_by(delta, loop);
+    }
+
+    bool move_to(menu_index_t index) {
+        _encoder.write_op16(TRACE_MOVE_TO, index);
+        return _ms.move_to(index);
+    }
+
+    bool home() {
+        _encoder.write_op(TRACE_HOME);
+        return _ms.home();
+    }
+
+    bool end() {
+        _encoder.write_op(TRACE_END);
+        return _ms.end();
+    }
+
+    void select(bool reset=false) {
+        _encoder.write_op(TRACE_SELECT | (reset ? TRACE_FLAG : 0));
+        _ms.select(reset);
+    }
+
+    bool back(uint8_t levels=1) {
+        _encoder.write_op8(TRACE_BACK, levels);
+        return _ms.back(levels);
+    }
+
+    void reset() {
+        _encoder.write_op(TRACE_RESET);
+        _ms.reset();
+    }
+
+    bool jump_to(const menu_index_t* indices, uint8_t length) {
+        _encoder.write_jump(indices, length);
+        return _ms.jump_to(indices, length);
+    }
+
+    void display() {
+        _encoder.write_op(TRACE_DISPLAY);
+        _ms.display();
+    }
+
+    MenuSystem& get_menu_system() const { return _ms; }
+
+private:
+    MenuSystem& _ms;
+    MenuTraceEncoder& _encoder;
+};
+
+//! \brief Replays a trace recorded by MenuRecorder
+//!
+//! The MenuSystem must be built on the same tree as the recorded one and
+//! render through a MenuTraceRenderer, whose digests are compared with the
+//! recorded TRACE_FRAME records.
+//!
+//! \code
+//! MenuTraceFile file("session.trace", "rb");
+//! MenuTraceRenderer trace_renderer(null_renderer);
+//! MenuSystem ms(trace_renderer);
+//! build_menu(ms);
+//!
+//! MenuTracePlayer player(ms, trace_renderer, file);
+//! while (player.step() != MenuTracePlayer::STEP_END)
+//!     ;
+//! printf("%u frames differ\n", player.get_num_mismatches());
+//! \endcode
+class MenuTracePlayer {
+public:
+    //! \brief The results of step()
+    enum StepResult {
+        STEP_OK,       //!< a call was replayed or a frame matched
+        STEP_MISMATCH, //!< a frame differs from the recorded one
+        STEP_END,      //!< the trace ended
+        STEP_ERROR     //!< the trace is truncated or invalid
+    };
+
+    MenuTracePlayer(MenuSystem& ms, MenuTraceRenderer const& renderer, MenuTraceReader& reader)
+    : _ms(ms),
+    _renderer(renderer),
+    _reader(reader),
+    _last_op(0),
+    _num_frames(0),
+    _num_mismatches(0),
+    _has_header(false) {
+    }
+
+    //! \brief Replays the next record
+    StepResult step() {
+        if (!_has_header) {
+            uint8_t header[4];
+            if (!_reader.read(header, sizeof(header)))
+                return STEP_END;
+            if (header[0] != 'M' || header[1] != 'T' || header[2] != TRACE_VERSION)
+                return STEP_ERROR;
+            _has_header = true;
+        }
+
+        uint8_t op;
+        if (!_reader.read(&op, 1))
+            return STEP_END;
+        _last_op = op;
+
+        bool flag = (op & TRACE_FLAG) != 0;
+        uint16_t operand;
+        switch (op & ~TRACE_FLAG) {
+        case TRACE_NEXT:
+            _ms.next(flag);
+            break;
+        case TRACE_PREV:
+            _ms.prev(flag);
+            break;
+        case TRACE_MOVE_BY:
+            if (!read_uint16(operand))
+                return STEP_ERROR;
+            _ms.move_by((int16_t) operand, flag);
+            break;
+        case TRACE_MOVE_TO:
+            if (!read_uint16(operand))
+                return STEP_ERROR;
+            _ms.move_to((menu_index_t) operand);
+            break;
+        case TRACE_HOME:
+            _ms.home();
+            break;
+        case TRACE_END:
+            _ms.end();
+            break;
+        case TRACE_SELECT:
+            _ms.select(flag);
+            break;
+        case TRACE_BACK: {
+            uint8_t levels;
+            if (!_reader.read(&levels, 1))
+                return STEP_ERROR;
+            _ms.back(levels);
+            break;
+        }
+        case TRACE_RESET:
+            _ms.reset();
+            break;
+        case TRACE_JUMP: {
+            uint8_t length;
+            menu_index_t indices[MENUSYSTEM_MAX_DEPTH];
+            if (!_reader.read(&length, 1) || length > MENUSYSTEM_MAX_DEPTH)
+                return STEP_ERROR;
+            for (uint8_t i = 0; i < length; ++i) {
+                if (!read_uint16(operand))
+                    return STEP_ERROR;
+                indices[i] = (menu_index_t) operand;
+            }
+            _ms.jump_to(indices, length);
+            break;
+        }
+        case TRACE_DISPLAY:
+            _ms.display();
+            break;
+        case TRACE_FRAME: {
+            uint8_t digest[4];
+            if (!_reader.read(digest, sizeof(digest)))
+                return STEP_ERROR;
+            _num_frames++;
+            uint32_t expected = digest[0] | (uint32_t) digest[1] << 8
+                | (uint32_t) digest[2] << 16 | (uint32_t) digest[3] << 24;
+            if (expected != _renderer.get_digest()) {
+                _num_mismatches++;
+                return STEP_MISMATCH;
+            }
+            break;
+        }
+        default:
+            return STEP_ERROR;
+        }
+        return STEP_OK;
+    }
+
+    //! \returns The opcode of the last record replayed.
+    uint8_t get_last_op() const { return _last_op; }
+
+    //! \returns The number of recorded frames compared so far.
+    uint32_t get_num_frames() const { return _num_frames; }
+
+    //! \returns The number of recorded frames that differed.
+    uint32_t get_num_mismatches() const { return _num_mismatches; }
+
+private:
+    bool read_uint16(uint16_t& value) {
+        uint8_t bytes[2];
+        if (!_reader.read(bytes, sizeof(bytes)))
+            return false;
+        value = bytes[0] | (uint16_t) bytes[1] << 8;
+        return true;
+    }
+
+private:
+    MenuSystem& _ms;
+    MenuTraceRenderer const& _renderer;
+    MenuTraceReader& _reader;
+    uint8_t _last_op;
+    uint32_t _num_frames;
+    uint32_t _num_mismatches;
+    bool _has_header;
+};
+
+#endif // MENU_TRACE_H
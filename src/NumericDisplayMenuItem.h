@@ -29,9 +29,10 @@ public:
 	//!                        float formatter will be used.
 	NumericDisplayMenuItem(const char* basename, SelectFnPtr select_fn,
 		float value,FormatValueFnPtr format_value_fn = nullptr)
-		: MenuItem(basename, select_fn),
+		: MenuItem(basename, select_fn, TYPE_NUMERIC_DISPLAY_MENU_ITEM),
         _value(value),
-        _format_value_fn(format_value_fn) {}
+        _format_value_fn(format_value_fn),
+        _format_value_buffer_fn(nullptr) {}
 
 	//!
 	//! \brief Sets the custom number formatter.
@@ -41,27 +42,34 @@ public:
 	//!
 	void set_number_formatter(FormatValueFnPtr format_value_fn) { _format_value_fn = format_value_fn; }
 
+	//! \copydoc NumericMenuItem::set_value_formatter
+	void set_value_formatter(FormatValueBufferFnPtr format_value_buffer_fn) { _format_value_buffer_fn = format_value_buffer_fn; }
+
 	float get_value() const { return _value; }
 
 	void set_value(float value) { _value = value; }
 
+	//! \copydoc NumericMenuItem::format_value
+	size_t format_value(char* buffer, size_t size) const {
+        return menu_format_value(_value, buffer, size, _format_value_fn, _format_value_buffer_fn);
+    }
+
 	String get_formatted_value() const {
-        String buffer;
-        if (_format_value_fn != nullptr)
-            buffer += _format_value_fn(_value);
-        else
-            buffer += _value;
-        return buffer;
+        if (_format_value_fn != nullptr && _format_value_buffer_fn == nullptr)
+            return _format_value_fn(_value);
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        format_value(buffer, sizeof(buffer));
+        return String(buffer);
     }
 
 	virtual void render(MenuComponentRenderer const& renderer) const {
-        MenuComponentRenderer2 const& my_renderer = static_cast<MenuComponentRenderer2 const&>(renderer);
-        my_renderer.render_numeric_display_menu_item(*this);
+        renderer.render_numeric_display_menu_item(*this);
     }
 
 protected:
 	float _value;
 	FormatValueFnPtr _format_value_fn;
+	FormatValueBufferFnPtr _format_value_buffer_fn;
 };
 
 #endif
@@ -0,0 +1,372 @@
+/**
+ * \file    NumericMenuItemT.h
+ * \brief   NumericMenuItemT, a NumericMenuItem with a templated value type
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef NUMERIC_MENU_ITEM_T_H
+#define NUMERIC_MENU_ITEM_T_H
+
+#include "MenuSystem.h"
+
+//! \brief Writes an unsigned integer into buffer without using printf
+//! \returns The length of the text written.
+inline size_t menu_format_uint(uint32_t value, char* buffer, size_t size) {
+    if (size == 0)
+        return 0;
+
+    char digits[10];
+    uint8_t num_digits = 0;
+    do {
+        digits[num_digits++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+
+    size_t len = 0;
+    while (num_digits > 0 && len < size - 1)
+        buffer[len++] = digits[--num_digits];
+    buffer[len] = '\0';
+    return len;
+}
+
+//! \brief Writes a signed integer into buffer without using printf
+//! \returns The length of the text written.
+inline size_t menu_format_int(int32_t value, char* buffer, size_t size) {
+    if (value >= 0)
+        return menu_format_uint((uint32_t) value, buffer, size);
+    if (size < 2)
+        return menu_format_uint(0, buffer, 0);
+
+    buffer[0] = '-';
+    return 1 + menu_format_uint(0u - (uint32_t) value, buffer + 1, size - 1);
+}
+
+//! \brief A signed binary fixed-point number in Q format
+//!
+//! The value is stored as RAW scaled by 2^FRAC_BITS, so all arithmetic is
+//! done on integers and no floating point code is pulled in. E.g.
+//! FixedPoint<8> is Q7.8: values from -128 to 127.996 in steps of 1/256.
+//!
+//! \tparam FRAC_BITS The number of fractional bits, 1 to 15.
+//! \tparam RAW The integer type that stores the scaled value.
+template <uint8_t FRAC_BITS, typename RAW=int16_t>
+class FixedPoint {
+    static_assert(FRAC_BITS > 0 && FRAC_BITS < 16, "FixedPoint needs 1 to 15 fractional bits");
+
+public:
+    //! \brief The number of decimals printed by menu_format_number
+    static const uint8_t DECIMALS = (FRAC_BITS * 3 + 9) / 10;
+
+public:
+    constexpr FixedPoint() : _raw(0) {}
+
+    //! \brief Construct a FixedPoint from an integer
+    constexpr FixedPoint(int value) : _raw((RAW) (value * (1L << FRAC_BITS))) {}
+
+    //! \brief Construct a FixedPoint from its scaled representation
+    static constexpr FixedPoint from_raw(RAW raw) { return FixedPoint(raw, RawTag()); }
+
+    //! \brief Construct a FixedPoint that approximates numerator / denominator
+    //!
+    //! E.g. FixedPoint<8>::from_ratio(1, 10) for 0.1.
+    static constexpr FixedPoint from_ratio(int32_t numerator, int32_t denominator) {
+        return from_raw((RAW) (numerator * (1L << FRAC_BITS) / denominator));
+    }
+
+    //! \returns The value scaled by 2^FRAC_BITS.
+    constexpr RAW raw() const { return _raw; }
+
+    constexpr FixedPoint operator+(FixedPoint other) const { return from_raw(_raw + other._raw); }
+    constexpr FixedPoint operator-(FixedPoint other) const { return from_raw(_raw - other._raw); }
+    FixedPoint& operator+=(FixedPoint other) { _raw += other._raw; return *this; }
+    FixedPoint& operator-=(FixedPoint other) { _raw -= other._raw; return *this; }
+
+    constexpr bool operator==(FixedPoint other) const { return _raw == other._raw; }
+    constexpr bool operator!=(FixedPoint other) const { return _raw != other._raw; }
+    constexpr bool operator<(FixedPoint other) const { return _raw < other._raw; }
+    constexpr bool operator>(FixedPoint other) const { return _raw > other._raw; }
+    constexpr bool operator<=(FixedPoint other) const { return _raw <= other._raw; }
+    constexpr bool operator>=(FixedPoint other) const { return _raw >= other._raw; }
+
+private:
+    struct RawTag {};
+    constexpr FixedPoint(RAW raw, RawTag) : _raw(raw) {}
+
+    RAW _raw;
+};
+
+//! \brief Default formatters of NumericMenuItemT
+//!
+//! One overload per supported value type; only the ones that are used end
+//! up in the binary.
+//!
+//! \returns The length of the text written.
+inline size_t menu_format_number(int8_t value, char* buffer, size_t size) { return menu_format_int(value, buffer, size); }
+inline size_t menu_format_number(int16_t value, char* buffer, size_t size) { return menu_format_int(value, buffer, size); }
+inline size_t menu_format_number(int32_t value, char* buffer, size_t size) { return menu_format_int(value, buffer, size); }
+inline size_t menu_format_number(uint8_t value, char* buffer, size_t size) { return menu_format_uint(value, buffer, size); }
+inline size_t menu_format_number(uint16_t value, char* buffer, size_t size) { return menu_format_uint(value, buffer, size); }
+inline size_t menu_format_number(uint32_t value, char* buffer, size_t size) { return menu_format_uint(value, buffer, size); }
+inline size_t menu_format_number(float value, char* buffer, size_t size) { return menu_format_float(value, buffer, size); }
+
+//! \brief Writes value with FixedPoint::DECIMALS rounded decimals
+template <uint8_t FRAC_BITS, typename RAW>
+inline size_t menu_format_number(FixedPoint<FRAC_BITS, RAW> value, char* buffer, size_t size) {
+    typedef FixedPoint<FRAC_BITS, RAW> fixed_t;
+
+    int32_t raw = value.raw();
+    uint32_t magnitude = raw < 0 ? 0u - (uint32_t) raw : (uint32_t) raw;
+    uint32_t int_part = magnitude >> FRAC_BITS;
+    uint32_t frac_part = magnitude & ((1UL << FRAC_BITS) - 1);
+
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < fixed_t::DECIMALS; ++i)
+        scale *= 10;
+
+    // Round to the nearest printable decimal
+    uint32_t decimals = (frac_part * scale + (1UL << (FRAC_BITS - 1))) >> FRAC_BITS;
+    if (decimals >= scale) {
+        int_part++;
+        decimals -= scale;
+    }
+
+    size_t len = 0;
+    if (raw < 0 && (int_part != 0 || decimals != 0) && size > 1)
+        buffer[len++] = '-';
+    len += menu_format_uint(int_part, buffer + len, size - len);
+
+    if (len + 1 < size) {
+        buffer[len++] = '.';
+        for (uint32_t digit = scale / 10; digit != 0 && len + 1 < size; digit /= 10)
+            buffer[len++] = '0' + (decimals / digit) % 10;
+        buffer[len] = '\0';
+    }
+    return len;
+}
+
+//! \brief Converts a value to a 32 bit integer with the same ordering
+inline int32_t menu_numeric_raw(int8_t value) { return value; }
+inline int32_t menu_numeric_raw(int16_t value) { return value; }
+inline int32_t menu_numeric_raw(int32_t value) { return value; }
+inline int32_t menu_numeric_raw(uint8_t value) { return value; }
+inline int32_t menu_numeric_raw(uint16_t value) { return value; }
+inline int32_t menu_numeric_raw(uint32_t value) { return (int32_t) value; }
+
+template <uint8_t FRAC_BITS, typename RAW>
+inline int32_t menu_numeric_raw(FixedPoint<FRAC_BITS, RAW> value) { return value.raw(); }
+
+//! \brief Returns the position of value between min_value and max_value
+//!
+//! Used by NumericMenuItemT::get_value_position.
+//!
+//! \returns 0 for min_value up to scale for max_value.
+template <typename T>
+inline uint8_t menu_value_position(T value, T min_value, T max_value, uint8_t scale) {
+    // Unsigned differences are exact even if the signed ones overflow
+    uint32_t range = (uint32_t) menu_numeric_raw(max_value) - (uint32_t) menu_numeric_raw(min_value);
+    uint32_t offset = (uint32_t) menu_numeric_raw(value) - (uint32_t) menu_numeric_raw(min_value);
+    if (range == 0 || scale == 0)
+        return 0;
+    if (offset >= range)
+        return scale;
+    if (range <= UINT32_MAX / scale)
+        return (uint8_t) (offset * scale / range);
+    return (uint8_t) (offset / (range / scale));
+}
+
+inline uint8_t menu_value_position(float value, float min_value, float max_value, uint8_t scale) {
+    if (max_value <= min_value || value <= min_value)
+        return 0;
+    if (value >= max_value)
+        return scale;
+    return (uint8_t) (scale * (value - min_value) / (max_value - min_value));
+}
+
+//! \brief A NumericMenuItem for any integer or fixed-point value type
+//!
+//! NumericMenuItemT behaves like NumericMenuItem: selecting it toggles focus,
+//! and while it has focus next and prev step the value by the increment,
+//! clamping or looping at the limits. Integer and FixedPoint values step
+//! exactly, without the drift of repeated float additions, and a build that
+//! only uses them doesn't link any floating point code.
+//!
+//! The difference max_value - min_value must be representable in T.
+//!
+//! \code
+//! NumericMenuItemT<int16_t> mi_speed("Speed", nullptr, 50, 0, 1000, 5);
+//! NumericMenuItemT<FixedPoint<8> > mi_gain("Gain", nullptr, 1, 0, 4,
+//!                                          FixedPoint<8>::from_ratio(1, 4));
+//! \endcode
+//!
+//! \tparam T The value type: an integer type, FixedPoint or float.
+//!
+//! \see NumericValueMenuItem
+//! \see MenuComponentRenderer::render_numeric_value_menu_item
+template <typename T>
+class NumericMenuItemT : public NumericValueMenuItem {
+public:
+    //! \brief Callback for formatting the value into a buffer
+    //!
+    //! \param value The value to convert.
+    //! \param buffer The buffer to write the 0-terminated text to.
+    //! \param size The size of buffer in bytes.
+    using FormatValueFnPtr = void (*)(const T value, char* buffer, size_t size);
+
+public:
+    //! Constructor
+    //!
+    //! @param name The name of the menu item.
+    //! @param select_fn The function to call when this MenuItem is selected.
+    //! @param value Default value.
+    //! @param min_value The minimum value.
+    //! @param max_value The maximum value.
+    //! @param increment How much the value should be incremented by.
+    //! @param format_value_fn The custom formatter. If nullptr
+    //!                        menu_format_number will be used.
+    NumericMenuItemT(const char* name, SelectFnPtr select_fn,
+                     T value, T min_value, T max_value, T increment=T(1),
+                     FormatValueFnPtr format_value_fn=nullptr)
+    : NumericValueMenuItem(name, select_fn),
+    _value(value),
+    _min_value(min_value),
+    _max_value(max_value),
+    _increment(increment),
+    _format_value_fn(format_value_fn) {
+        if (_increment < T(0)) _increment = T(0) - _increment;
+        if (_min_value > _max_value) {
+            T tmp = _max_value;
+            _max_value = _min_value;
+            _min_value = tmp;
+        }
+    }
+
+    //! \brief Sets the custom value formatter
+    //!
+    //! \param format_value_fn The custom formatter. If nullptr
+    //!                        menu_format_number will be used.
+    void set_number_formatter(FormatValueFnPtr format_value_fn) { _format_value_fn = format_value_fn; }
+
+    T get_value() const { return _value; }
+    T get_min_value() const { return _min_value; }
+    T get_max_value() const { return _max_value; }
+    T get_increment() const { return _increment; }
+
+    void set_value(T value) { _value = value; }
+    void set_min_value(T value) { _min_value = value; }
+    void set_max_value(T value) { _max_value = value; }
+    void set_increment(T value) { _increment = value; }
+
+    //! \copydoc NumericValueMenuItem::format_value
+    virtual size_t format_value(char* buffer, size_t size) const {
+        if (size == 0)
+            return 0;
+        if (_format_value_fn == nullptr)
+            return menu_format_number(_value, buffer, size);
+
+        buffer[0] = '\0';
+        _format_value_fn(_value, buffer, size);
+        buffer[size - 1] = '\0';
+        return strlen(buffer);
+    }
+
+    //! \copydoc NumericValueMenuItem::get_value_position
+    virtual uint8_t get_value_position(uint8_t scale) const {
+        return menu_value_position(_value, _min_value, _max_value, scale);
+    }
+
+    //! \copydoc MenuComponent::save_state
+    virtual uint8_t save_state(uint8_t* buffer, uint8_t size) const {
+        if (size < sizeof(T))
+            return 0;
+        memcpy(buffer, &_value, sizeof(T));
+        return sizeof(T);
+    }
+
+    //! \copydoc MenuComponent::load_state
+    //!
+    //! Values outside of the range of the item are rejected.
+    virtual bool load_state(const uint8_t* buffer, uint8_t size) {
+        T value;
+        if (size != sizeof(T))
+            return false;
+        memcpy(&value, buffer, sizeof(T));
+        if (value < _min_value || value > _max_value)
+            return false;
+        _value = value;
+        return true;
+    }
+
+protected:
+    virtual bool next(bool loop=false) {
+        if (_max_value - _value < _increment)
+            _value = loop ? _min_value : _max_value;
+        else
+            _value += _increment;
+        return true;
+    }
+
+    virtual bool prev(bool loop=false) {
+        if (_value - _min_value < _increment)
+            _value = loop ? _max_value : _min_value;
+        else
+            _value -= _increment;
+        return true;
+    }
+
+    //! \copydoc MenuComponent::move_by
+    //!
+    //! Takes O(log |delta|) additions unless the value wraps around; T needs
+    //! no multiplication.
+    virtual bool move_by(int16_t delta, bool loop=false) {
+        if (delta == 0)
+            return false;
+
+        bool up = delta > 0;
+        Difference room = up ? _max_value - _value : _value - _min_value;
+        Difference total = Difference(0);
+        if (!sum_increments(up ? delta : -(int32_t) delta, room, total)) {
+            if (loop)
+                return NumericValueMenuItem::move_by(delta, loop);
+            _value = up ? _max_value : _min_value;
+        } else if (up) {
+            _value += total;
+        } else {
+            _value -= total;
+        }
+        return true;
+    }
+
+private:
+    // Like in next() and prev(), differences of small integers are ints
+    typedef decltype(T() - T()) Difference;
+
+    //! \brief Adds up n increments by doubling, as long as they fit in room
+    //! \returns false if n increments don't fit.
+    bool sum_increments(uint16_t n, Difference room, Difference& total) const {
+        Difference power = _increment;
+        for (; n != 0; n >>= 1) {
+            if (n & 1) {
+                if (room - total < power)
+                    return false;
+                total += power;
+            }
+            if (n > 1) {
+                // A larger bit of n is still to come
+                if (power > room || room - power < power)
+                    return false;
+                power += power;
+            }
+        }
+        return true;
+    }
+
+protected:
+    T _value;
+    T _min_value;
+    T _max_value;
+    T _increment;
+    FormatValueFnPtr _format_value_fn;
+};
+
+#endif // NUMERIC_MENU_ITEM_T_H
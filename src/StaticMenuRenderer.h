@@ -0,0 +1,113 @@
+/**
+ * \file    StaticMenuRenderer.h
+ * \brief   StaticMenuRenderer, a renderer dispatched at compile time
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef STATIC_MENU_RENDERER_H
+#define STATIC_MENU_RENDERER_H
+
+#include "MenuSystem.h"
+#include "NumericDisplayMenuItem.h"
+#include "TextEditMenuItem.h"
+#include "ToggleMenuItem.h"
+
+//! \brief A MenuComponentRenderer whose hooks are resolved at compile time
+//!
+//! StaticMenuRenderer is a CRTP base: Derived implements render() and only
+//! the draw_* hooks it needs. render_component() picks the hook with a switch
+//! on MenuComponent::get_type, so drawing a component that way is a direct,
+//! inlinable call instead of the two virtual calls of MenuComponent::render.
+//! Only render_component() avoids them: MenuSystem::display still reaches
+//! the renderer through the virtual render_changes(), once per frame, and
+//! the class keeps the vtable of MenuComponentRenderer.
+//!
+//! Hooks that aren't implemented fall back to a more general one: the item
+//! hooks to draw_menu_item, draw_menu_item and draw_menu to draw_component,
+//! which draws nothing. Components of client classes, with a type from
+//! MenuComponent::TYPE_USER up, are passed to draw_component.
+//!
+//! A StaticMenuRenderer is also a complete MenuComponentRenderer, so
+//! MenuComponent::render keeps working with it, at the usual cost of two
+//! virtual calls per component.
+//!
+//! \code
+//! class MyRenderer : public StaticMenuRenderer<MyRenderer> {
+//! public:
+//!     void render(Menu const& menu) const {
+//!         for (int i = 0; i < menu.get_num_components(); ++i)
+//!             render_component(*menu.get_menu_component(i));
+//!     }
+//!     void draw_component(MenuComponent const& component) const {
+//!         Serial.println(component.get_name());
+//!     }
+//! };
+//! \endcode
+//!
+//! \tparam Derived The renderer class.
+template <class Derived>
+class StaticMenuRenderer : public MenuComponentRenderer {
+public:
+    //! \brief Draws component with the draw_* hook for its type
+    void render_component(MenuComponent const& component) const {
+        Derived const& renderer = derived();
+        switch (component.get_type()) {
+        case MenuComponent::TYPE_MENU:
+            renderer.draw_menu(static_cast<Menu const&>(component));
+            break;
+        case MenuComponent::TYPE_MENU_ITEM:
+            renderer.draw_menu_item(static_cast<MenuItem const&>(component));
+            break;
+        case MenuComponent::TYPE_BACK_MENU_ITEM:
+            renderer.draw_back_menu_item(static_cast<BackMenuItem const&>(component));
+            break;
+        case MenuComponent::TYPE_NUMERIC_MENU_ITEM:
+            renderer.draw_numeric_menu_item(static_cast<NumericMenuItem const&>(component));
+            break;
+        case MenuComponent::TYPE_NUMERIC_VALUE_MENU_ITEM:
+            renderer.draw_numeric_value_menu_item(static_cast<NumericValueMenuItem const&>(component));
+            break;
+        case MenuComponent::TYPE_TOGGLE_MENU_ITEM:
+            renderer.draw_toggle_menu_item(static_cast<ToggleMenuItem const&>(component));
+            break;
+        case MenuComponent::TYPE_NUMERIC_DISPLAY_MENU_ITEM:
+            renderer.draw_numeric_display_menu_item(static_cast<NumericDisplayMenuItem const&>(component));
+            break;
+        case MenuComponent::TYPE_TEXT_EDIT_MENU_ITEM:
+            renderer.draw_text_edit_menu_item(static_cast<TextEditMenuItem const&>(component));
+            break;
+        default:
+            renderer.draw_component(component);
+            break;
+        }
+    }
+
+    // Default hooks, hidden by the hooks of Derived
+
+    void draw_component(MenuComponent const& component) const {}
+    void draw_menu(Menu const& menu) const { derived().draw_component(menu); }
+    void draw_menu_item(MenuItem const& menu_item) const { derived().draw_component(menu_item); }
+    void draw_back_menu_item(BackMenuItem const& menu_item) const { derived().draw_menu_item(menu_item); }
+    void draw_numeric_menu_item(NumericMenuItem const& menu_item) const { derived().draw_menu_item(menu_item); }
+    void draw_numeric_value_menu_item(NumericValueMenuItem const& menu_item) const { derived().draw_menu_item(menu_item); }
+    void draw_toggle_menu_item(ToggleMenuItem const& menu_item) const { derived().draw_menu_item(menu_item); }
+    void draw_numeric_display_menu_item(NumericDisplayMenuItem const& menu_item) const { derived().draw_menu_item(menu_item); }
+    void draw_text_edit_menu_item(TextEditMenuItem const& menu_item) const { derived().draw_menu_item(menu_item); }
+
+    // MenuComponentRenderer, for MenuComponent::render
+
+    void render_menu_item(MenuItem const& menu_item) const { render_component(menu_item); }
+    void render_back_menu_item(BackMenuItem const& menu_item) const { render_component(menu_item); }
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const { render_component(menu_item); }
+    void render_numeric_value_menu_item(NumericValueMenuItem const& menu_item) const { render_component(menu_item); }
+    void render_toggle_menu_item(ToggleMenuItem const& menu_item) const { render_component(menu_item); }
+    void render_numeric_display_menu_item(NumericDisplayMenuItem const& menu_item) const { render_component(menu_item); }
+    void render_text_edit_menu_item(TextEditMenuItem const& menu_item) const { render_component(menu_item); }
+    void render_menu(Menu const& menu) const { render_component(menu); }
+
+private:
+    Derived const& derived() const { return static_cast<Derived const&>(*this); }
+};
+
+#endif // STATIC_MENU_RENDERER_H
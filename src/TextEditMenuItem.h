@@ -16,12 +16,81 @@ enum EDITING_STATE {
 	SELECTION, EDITING
 };
 
+//! \name Character sets for TextEditMenuItem::set_charset
+//!
+//! The characters are offered in the order of the string. A custom set is
+//! any '\0' terminated string declared with MENUSYSTEM_PROGMEM, like these.
+//!
+//! Each set is a function-local static of an inline function, so there is
+//! one copy in the program however many files include this header.
+//! @{
+inline const char* menu_charset_printable() {
+	static const char charset[] MENUSYSTEM_PROGMEM =
+		" !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+	return charset;
+}
+
+inline const char* menu_charset_digits() {
+	static const char charset[] MENUSYSTEM_PROGMEM = "0123456789";
+	return charset;
+}
+
+inline const char* menu_charset_hex() {
+	static const char charset[] MENUSYSTEM_PROGMEM = "0123456789ABCDEF";
+	return charset;
+}
+
+inline const char* menu_charset_upper() {
+	static const char charset[] MENUSYSTEM_PROGMEM = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	return charset;
+}
+
+inline const char* menu_charset_lower() {
+	static const char charset[] MENUSYSTEM_PROGMEM = "abcdefghijklmnopqrstuvwxyz";
+	return charset;
+}
+
+inline const char* menu_charset_alnum() {
+	static const char charset[] MENUSYSTEM_PROGMEM =
+		"0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+	return charset;
+}
+
+inline const char* menu_charset_symbols() {
+	static const char charset[] MENUSYSTEM_PROGMEM = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+	return charset;
+}
+
+inline const char* menu_charset_hostname() {
+	static const char charset[] MENUSYSTEM_PROGMEM = "abcdefghijklmnopqrstuvwxyz0123456789-.";
+	return charset;
+}
+
+#define MENU_CHARSET_PRINTABLE menu_charset_printable()
+#define MENU_CHARSET_DIGITS menu_charset_digits()
+#define MENU_CHARSET_HEX menu_charset_hex()
+#define MENU_CHARSET_UPPER menu_charset_upper()
+#define MENU_CHARSET_LOWER menu_charset_lower()
+#define MENU_CHARSET_ALNUM menu_charset_alnum()
+#define MENU_CHARSET_SYMBOLS menu_charset_symbols()
+#define MENU_CHARSET_HOSTNAME menu_charset_hostname()
+//! @}
+
 //! \brief A MenuItem for editing a short text string
 //!
 //! TextEditMenuItem is a menu item for automatically
 //! edit a short text buffer. It's specialised for use
 //! with an rotary encoder. On editing ending the
 //! the user-defined Menu::_select_fn callback is called.
+//!
+//! The characters offered while editing come from a character set, see
+//! set_charset, and are stepped through in O(1); move_by steps several at
+//! once, so the item can be driven by a MenuAccelerator. next_class and
+//! prev_class jump to the next group of the set, e.g. from the digits to
+//! the capitals, for a long press or a double click. insert_char,
+//! delete_char and clear_to_end edit the buffer in place.
+//!
+//! The last byte of the buffer is always the '\0'.
 class TextEditMenuItem: public MenuItem {
 public:
 	//! Constructor
@@ -30,7 +99,17 @@ public:
 	//! @param select_fn The function to call when this MenuItem is selected.
 	//! @param value the buffer with the text to edit.
 	//! @param size size of the buffer
-	TextEditMenuItem(const char* basename, SelectFnPtr select_fn, char* value, uint8_t size) : MenuItem(basename, select_fn), _value(value), _size(size) {}
+	//! @param charset the characters offered, see set_charset.
+	TextEditMenuItem(const char* basename, SelectFnPtr select_fn, char* value, uint8_t size,
+	                 const char* charset=MENU_CHARSET_PRINTABLE)
+	: MenuItem(basename, select_fn, TYPE_TEXT_EDIT_MENU_ITEM),
+	_editing_state(SELECTION),
+	_value(value),
+	_size(size),
+	_pos(0),
+	_char_index(0) {
+		set_charset(charset);
+	}
 
 
 	char* get_value() const { return _value; }
@@ -41,29 +120,226 @@ public:
 	void set_size(uint8_t size) { _size = size; }
 	EDITING_STATE get_edit_state() const {return _editing_state;}
 
-	virtual void render(MenuComponentRenderer const& renderer) const { MenuComponentRenderer2 const& my_renderer = static_cast<MenuComponentRenderer2 const&>(renderer); my_renderer.render_text_edit_menu_item(*this); }
+	//! \brief Sets the characters offered while editing
+	//!
+	//! \param charset A '\0' terminated string in MENUSYSTEM_PROGMEM, e.g.
+	//!                MENU_CHARSET_HEX, of at most 255 characters.
+	void set_charset(const char* charset) {
+		_charset = charset;
+		_charset_size = 0;
+		while (_charset_size < 255 && charset_at(_charset_size) != '\0')
+			_charset_size++;
+		_char_index = 0;
+	}
+
+	const char* get_charset() const { return _charset; }
+
+	//! \brief Inserts c before the character at the cursor
+	//!
+	//! If the buffer is full, the last character is dropped.
+	//!
+	//! \returns false if the cursor isn't on the text.
+	bool insert_char(char c) {
+		uint8_t length = strlen(_value);
+		if (_pos == 0 || _pos - 1 > length)
+			return false;
+
+		uint8_t index = _pos - 1;
+		if (length == _size - 1)
+			_value[--length] = '\0';
+		memmove(_value + index + 1, _value + index, length - index + 1);
+		_value[index] = c;
+		return true;
+	}
+
+	//! \brief Removes the character at the cursor
+	//! \returns false if the cursor isn't on a character.
+	bool delete_char() {
+		uint8_t length = strlen(_value);
+		if (_pos == 0 || _pos - 1 >= length)
+			return false;
+
+		uint8_t index = _pos - 1;
+		memmove(_value + index, _value + index + 1, length - index);
+		return true;
+	}
+
+	//! \brief Removes the characters from the cursor to the end
+	//! \returns false if the cursor isn't on the text.
+	bool clear_to_end() {
+		uint8_t length = strlen(_value);
+		if (_pos == 0 || _pos - 1 > length)
+			return false;
+		_value[_pos - 1] = '\0';
+		return true;
+	}
+
+	//! \brief Changes the character at the cursor to the first character of
+	//!        the next group of the charset
+	//!
+	//! The groups are the runs of spaces, symbols, digits, capitals and small
+	//! letters of the charset; the last group is followed by the first.
+	//!
+	//! \returns false if the item isn't editing a character.
+	bool next_class() {
+		if (_editing_state != EDITING || _pos == 0 || _charset_size == 0)
+			return false;
+
+		uint8_t index = find_char_index();
+		if (index == _charset_size) {
+			index = 0;
+		} else {
+			uint8_t char_class = get_char_class(charset_at(index));
+			do {
+				index++;
+			} while (index < _charset_size && get_char_class(charset_at(index)) == char_class);
+			if (index == _charset_size)
+				index = 0;
+		}
+		set_char(index);
+		return true;
+	}
+
+	//! \brief Changes the character at the cursor to the first character of
+	//!        its group, or of the previous group if it already is
+	//! \see next_class
+	bool prev_class() {
+		if (_editing_state != EDITING || _pos == 0 || _charset_size == 0)
+			return false;
+
+		uint8_t index = find_char_index();
+		if (index == _charset_size || index == 0)
+			index = _charset_size;
+		else if (get_char_class(charset_at(index - 1)) == get_char_class(charset_at(index)))
+			index++;
+
+		// Back to the first character of the run before index
+		index--;
+		uint8_t char_class = get_char_class(charset_at(index));
+		while (index > 0 && get_char_class(charset_at(index - 1)) == char_class)
+			index--;
+		set_char(index);
+		return true;
+	}
+
+	virtual void render(MenuComponentRenderer const& renderer) const { renderer.render_text_edit_menu_item(*this); }
+
+	//! Saves the whole buffer, at most size bytes of it, so the record
+	//! has the same size whatever the text.
+	virtual uint8_t save_state(uint8_t* buffer, uint8_t size) const {
+		uint8_t length = _size < size ? _size : size;
+		memcpy(buffer, _value, length);
+		return length;
+	}
+
+	virtual bool load_state(const uint8_t* buffer, uint8_t size) {
+		if (size == 0 || size > _size)
+			return false;
+		memcpy(_value, buffer, size);
+		if (size < _size)
+			_value[size] = '\0';
+		_value[_size - 1] = '\0';
+		return true;
+	}
+
+	//! The cursor, whether it's selecting or editing, and the index of the
+	//! character in the charset.
+	virtual uint8_t save_cursor_state(uint8_t* buffer, uint8_t size) const {
+		if (size < 3)
+			return 0;
+		buffer[0] = _pos;
+		buffer[1] = (uint8_t) _editing_state;
+		buffer[2] = _char_index;
+		return 3;
+	}
+
+	virtual bool load_cursor_state(const uint8_t* buffer, uint8_t size) {
+		if (size != 3 || buffer[0] > get_max_pos() || buffer[1] > EDITING)
+			return false;
+		_pos = buffer[0];
+		_editing_state = (EDITING_STATE) buffer[1];
+		_char_index = buffer[2];
+		return true;
+	}
 
 protected:
-	virtual bool next(bool loop = false);
-	virtual bool prev(bool loop = false);
+	virtual bool next(bool loop = false) { return move_by(1, loop); }
+	virtual bool prev(bool loop = false) { return move_by(-1, loop); }
+
+	//! \copydoc MenuComponent::move_by
+	//!
+	//! Moves the cursor while selecting a position and steps through the
+	//! charset while editing, in O(1).
+	virtual bool move_by(int16_t delta, bool loop = false);
 
 	virtual Menu* select();
 
-	char getNextValidChar(char value);
-	char getPrevValidChar(char value);
+	//! \returns The i-th character of the charset.
+	char charset_at(uint8_t i) const {
+#if defined(MENUSYSTEM_PGM_READ_BYTE)
+		return (char) MENUSYSTEM_PGM_READ_BYTE(_charset + i);
+#else
+		return _charset[i];
+#endif
+	}
+
+	//! \returns The group of c: space, symbol, digit, capital or small letter.
+	static uint8_t get_char_class(char c) {
+		if (c == ' ')
+			return 0;
+		if (c >= '0' && c <= '9')
+			return 2;
+		if (c >= 'A' && c <= 'Z')
+			return 3;
+		if (c >= 'a' && c <= 'z')
+			return 4;
+		return 1;
+	}
+
+private:
+	//! The last position the cursor can be on: the end of the text
+	uint8_t get_max_pos() const {
+		uint8_t length = strlen(_value);
+		return length + 1 < _size ? length + 1 : _size - 1;
+	}
+
+	//! \returns The index in the charset of the character at the cursor,
+	//!          _charset_size if it isn't in the charset.
+	uint8_t find_char_index() {
+		char c = _value[_pos - 1];
+		// Usually where the last step left it
+		if (_char_index < _charset_size && charset_at(_char_index) == c)
+			return _char_index;
+		for (_char_index = 0; _char_index < _charset_size; ++_char_index)
+			if (charset_at(_char_index) == c)
+				break;
+		return _char_index;
+	}
+
+	//! Writes the index-th character of the charset at the cursor
+	void set_char(uint8_t index) {
+		uint8_t i = _pos - 1;
+		if (_value[i] == '\0')
+			_value[i + 1] = '\0';
+		_value[i] = charset_at(index);
+		_char_index = index;
+	}
 
 protected:
 	EDITING_STATE _editing_state;
 	char* _value;
 	uint8_t _size;
 	uint8_t _pos;
+	const char* _charset;
+	uint8_t _charset_size;
+	uint8_t _char_index;
 };
 
 inline Menu* TextEditMenuItem::select() {
 	if (!_has_focus) {
 		_editing_state = SELECTION;
 		_has_focus = true;
-		_pos = 1;
+		_pos = get_max_pos() > 0 ? 1 : 0;
 	} else {
 		switch (_editing_state) {
 		case SELECTION:
@@ -78,66 +354,124 @@ inline Menu* TextEditMenuItem::select() {
 			break;
 		}
 	}
-	if (!_has_focus && _select_fn != nullptr)
-		_select_fn(this);
+	if (!_has_focus)
+		call_select_fn();
 	return nullptr;
 }
 
-inline char TextEditMenuItem::getNextValidChar(char value) {
-	char myValue = value;
-	if (myValue < 32) {
-		myValue = 32;
-	}
-	if (myValue >= 126) {
-		return 126;
-	}
-	return myValue + 1;
-}
-
-inline char TextEditMenuItem::getPrevValidChar(char value) {
-	char myValue = value;
-	if (myValue < 32) {
-		myValue = 32;
-	}
-	if (myValue <= 32) {
-		return 32;
-	}
-	return myValue - 1;
-}
-
-inline bool TextEditMenuItem::next(bool loop) {
+inline bool TextEditMenuItem::move_by(int16_t delta, bool loop) {
 	switch (_editing_state) {
-	case SELECTION:
-		_pos++;
-		if (_pos > _size) {
-			_pos = _size;
-		}
+	case SELECTION: {
+		int32_t pos = (int32_t) _pos + delta;
+		uint8_t max_pos = get_max_pos();
+		_pos = pos < 0 ? 0 : (pos > max_pos ? max_pos : (uint8_t) pos);
 		break;
+	}
 	case EDITING:
-		if (_pos > 0) {
-			_value[_pos - 1] = getNextValidChar(_value[_pos - 1]);
+		if (_pos > 0 && _charset_size > 0) {
+			int32_t index = find_char_index();
+			if (index == _charset_size)
+				index = delta > 0 ? delta - 1 : _charset_size + delta;
+			else
+				index += delta;
+			if (loop) {
+				index %= _charset_size;
+				if (index < 0)
+					index += _charset_size;
+			} else if (index < 0) {
+				index = 0;
+			} else if (index >= _charset_size) {
+				index = _charset_size - 1;
+			}
+			set_char((uint8_t) index);
 		}
 		break;
 	}
 	return true;
 }
 
-inline bool TextEditMenuItem::prev(bool loop) {
-	switch (_editing_state) {
-	case SELECTION:
-		if (_pos == 0) {
-		} else {
-			_pos--;
-		}
-		break;
-	case EDITING:
-		if (_pos > 0) {
-			_value[_pos - 1] = getPrevValidChar(_value[_pos - 1]);
-		}
-		break;
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+
+TEST_CASE( .name="text-edit-menu-item", .description="Editing with TextEditMenuItem.", .skip=0 ) {
+	CiutNullRenderer renderer;
+
+	SECTION("the constructor initializes the cursor and the state") {
+		char value[8] = "abc";
+		TextEditMenuItem item("text", nullptr, value, sizeof(value));
+		REQUIRE(item.get_pos() == 0);
+		REQUIRE(item.get_edit_state() == SELECTION);
+		REQUIRE(!item.has_focus());
+	}
+
+	SECTION("insert_char drops the last character of a full buffer") {
+		char value[5] = "abcd";
+		TextEditMenuItem item("text", nullptr, value, sizeof(value));
+		MenuSystem ms(renderer);
+		ms.get_root_menu().add_item(&item);
+		ms.select();
+		REQUIRE(item.get_pos() == 1);
+		REQUIRE(item.insert_char('x'));
+		REQUIRE(strcmp(value, "xabc") == 0);
+		ms.next(); ms.next(); ms.next();
+		REQUIRE(item.get_pos() == 4);
+		REQUIRE(item.insert_char('y'));
+		REQUIRE(strcmp(value, "xaby") == 0);
+	}
+
+	SECTION("delete_char works on a full buffer") {
+		char value[5] = "abcd";
+		TextEditMenuItem item("text", nullptr, value, sizeof(value));
+		MenuSystem ms(renderer);
+		ms.get_root_menu().add_item(&item);
+		ms.select();
+		ms.next(); ms.next(); ms.next();
+		REQUIRE(item.get_pos() == 4);
+		REQUIRE(item.delete_char());
+		REQUIRE(strcmp(value, "abc") == 0);
+		REQUIRE(!item.delete_char());
+		ms.prev(); ms.prev(); ms.prev();
+		REQUIRE(item.delete_char());
+		REQUIRE(strcmp(value, "bc") == 0);
+	}
+
+	SECTION("next_class and prev_class wrap around") {
+		char value[4] = ".";
+		TextEditMenuItem item("text", nullptr, value, sizeof(value), MENU_CHARSET_HOSTNAME);
+		MenuSystem ms(renderer);
+		ms.get_root_menu().add_item(&item);
+		REQUIRE(!item.next_class());
+		ms.select();
+		ms.select();
+		REQUIRE(item.get_edit_state() == EDITING);
+
+		REQUIRE(item.next_class());
+		REQUIRE(value[0] == 'a');
+		REQUIRE(item.next_class());
+		REQUIRE(value[0] == '0');
+		REQUIRE(item.next_class());
+		REQUIRE(value[0] == '-');
+		REQUIRE(item.next_class());
+		REQUIRE(value[0] == 'a');
+
+		REQUIRE(item.prev_class());
+		REQUIRE(value[0] == '-');
+		REQUIRE(item.prev_class());
+		REQUIRE(value[0] == '0');
+		REQUIRE(item.prev_class());
+		REQUIRE(value[0] == 'a');
+		REQUIRE(item.prev_class());
+		REQUIRE(value[0] == '-');
+	}
+
+	SECTION("load_state ends a short text") {
+		char value[8] = "abcdefg";
+		TextEditMenuItem item("text", nullptr, value, sizeof(value));
+		const uint8_t state[] = { 'x', 'y' };
+		REQUIRE(item.load_state(state, sizeof(state)));
+		REQUIRE(strcmp(value, "xy") == 0);
 	}
-	return true;
 }
 
-#endif // TEXT_EDIT_MENU_ITEM_H
+#endif // CIUT_ENABLED
 
+#endif // TEXT_EDIT_MENU_ITEM_H
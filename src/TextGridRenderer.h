@@ -0,0 +1,260 @@
+/**
+ * \file    TextGridRenderer.h
+ * \brief   TextGridRenderer, a character display renderer that only sends
+ *          the cells that changed
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ */
+#ifndef TEXT_GRID_RENDERER_H
+#define TEXT_GRID_RENDERER_H
+
+#include "MenuSystem.h"
+#include "MenuComponentRenderer2.h"
+#include "NumericDisplayMenuItem.h"
+#include "TextEditMenuItem.h"
+#include "ToggleMenuItem.h"
+
+#ifndef MENUSYSTEM_TEXT_GRID_MAX_GAP
+//! Changed cells separated by at most this many unchanged cells are sent in
+//! one write, which is cheaper than moving the cursor on most displays
+#define MENUSYSTEM_TEXT_GRID_MAX_GAP 2
+#endif
+
+//! \brief The display a TextGridRenderer draws on
+//!
+//! \see TextGridRenderer
+class TextGridBackend {
+public:
+    //! \brief Moves the cursor of the display to col, row
+    virtual void set_cursor(uint8_t col, uint8_t row) = 0;
+
+    //! \brief Writes length characters at the cursor
+    //!
+    //! The text isn't '\0' terminated.
+    virtual void write(const char* text, uint8_t length) = 0;
+
+    virtual ~TextGridBackend() {}
+};
+
+//! \brief A MenuComponentRenderer2 for character displays
+//!
+//! The menu is drawn into a frame buffer in RAM, one character per cell,
+//! which is compared with the frame last sent to the display. Only the runs
+//! of cells that changed are sent to the TextGridBackend, so moving the
+//! cursor typically rewrites two cells instead of clearing and reprinting
+//! the whole display.
+//!
+//! The first row shows the name of the menu unless set_show_title(false) is
+//! called; the other rows show the components, with a '>' in front of the
+//! current one, or a '*' when it has focus. Set MenuSystem::set_viewport to
+//! get_num_item_rows() so the MenuSystem scrolls the menu for the renderer.
+//!
+//! The draw methods are virtual: override them to change how an item looks,
+//! using print() and print_right() to write into the frame.
+//!
+//! Call invalidate() after drawing on the display outside of the renderer.
+//!
+//! \see StaticTextGridRenderer
+class TextGridRenderer : public MenuComponentRenderer2 {
+public:
+    //! \brief Shows the name of the menu in the first row
+    void set_show_title(bool show_title) { _show_title = show_title; invalidate(); }
+
+    //! \returns The number of rows showing components.
+    uint8_t get_num_item_rows() const { return _show_title ? _rows - 1 : _rows; }
+
+    uint8_t get_num_cols() const { return _cols; }
+    uint8_t get_num_rows() const { return _rows; }
+
+    //! \brief Forgets what the display shows so the next frame is sent whole
+    void invalidate() const { memset(_p_shown, 0, _cols * _rows); }
+
+    //! \copydoc MenuComponentRenderer::render
+    virtual void render(Menu const& menu) const {
+        memset(_p_frame, ' ', _cols * _rows);
+
+        uint8_t row = 0;
+        if (_show_title) {
+            move_to(0, row++);
+            print(menu.get_name());
+        }
+
+        // Keep the current component visible even without a viewport
+        uint8_t num_rows = _rows - row;
+        menu_index_t first = menu.get_first_visible();
+        menu_index_t current = menu.get_current_component_num();
+        if (current < first)
+            first = current;
+        else if (current >= first + num_rows)
+            first = current - num_rows + 1;
+
+        for (int i = first; i < menu.get_num_components() && row < _rows; ++i) {
+            MenuComponent const* cp_m_comp = menu.get_menu_component(i);
+            move_to(0, row++);
+            if (cp_m_comp->is_current())
+                print_char(cp_m_comp->has_focus() ? '*' : '>');
+            else
+                print_char(' ');
+            cp_m_comp->render(*this);
+        }
+
+        flush();
+    }
+
+    virtual void render_menu_item(MenuItem const& menu_item) const {
+        print(menu_item.get_name());
+    }
+
+    virtual void render_back_menu_item(BackMenuItem const& menu_item) const {
+        print(menu_item.get_name());
+    }
+
+    virtual void render_numeric_menu_item(NumericMenuItem const& menu_item) const {
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        menu_item.format_value(buffer, sizeof(buffer));
+        print(menu_item.get_name());
+        print_right(buffer);
+    }
+
+    virtual void render_numeric_value_menu_item(NumericValueMenuItem const& menu_item) const {
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        menu_item.format_value(buffer, sizeof(buffer));
+        print(menu_item.get_name());
+        print_right(buffer);
+    }
+
+    virtual void render_toggle_menu_item(ToggleMenuItem const& menu_item) const {
+        print(menu_item.get_name());
+        print_right(menu_item.get_state_str());
+    }
+
+    virtual void render_numeric_display_menu_item(NumericDisplayMenuItem const& menu_item) const {
+        char buffer[MENUSYSTEM_VALUE_BUFFER_SIZE];
+        menu_item.format_value(buffer, sizeof(buffer));
+        print(menu_item.get_name());
+        print_right(buffer);
+    }
+
+    virtual void render_text_edit_menu_item(TextEditMenuItem const& menu_item) const {
+        print(menu_item.get_name());
+        print_right(menu_item.get_value());
+    }
+
+    virtual void render_menu(Menu const& menu) const {
+        print(menu.get_name());
+        print_right(">");
+    }
+
+protected:
+    //! \param[in] backend The display to draw on.
+    //! \param[in] p_frame, p_shown Two buffers of cols * rows characters.
+    TextGridRenderer(TextGridBackend& backend, uint8_t cols, uint8_t rows,
+                     char* p_frame, char* p_shown)
+    : _backend(backend),
+    _p_frame(p_frame),
+    _p_shown(p_shown),
+    _cols(cols),
+    _rows(rows),
+    _col(0),
+    _row(0),
+    _show_title(true) {
+        invalidate();
+    }
+
+    //! \brief Moves the write position in the frame
+    void move_to(uint8_t col, uint8_t row) const {
+        _col = col;
+        _row = row;
+    }
+
+    //! \brief Writes c at the write position, clipped to the row
+    void print_char(char c) const {
+        if (_col < _cols)
+            _p_frame[_row * _cols + _col++] = c;
+    }
+
+    //! \brief Writes text at the write position, clipped to the row
+    void print(const char* text) const {
+        while (*text != '\0' && _col < _cols)
+            _p_frame[_row * _cols + _col++] = *text++;
+    }
+
+    //! \brief Writes text at the end of the row
+    //!
+    //! The text starts after the write position plus one space if it
+    //! doesn't fit, and is clipped.
+    void print_right(const char* text) const {
+        size_t length = strlen(text);
+        uint8_t col = _col + 1;
+        if (length < _cols && _cols - length > col)
+            col = _cols - length;
+        _col = col;
+        print(text);
+    }
+
+    //! \brief Sends the cells that differ from the shown frame
+    void flush() const {
+        for (uint8_t row = 0; row < _rows; ++row) {
+            const char* frame = _p_frame + row * _cols;
+            char* shown = _p_shown + row * _cols;
+
+            uint8_t col = 0;
+            while (col < _cols) {
+                if (frame[col] == shown[col]) {
+                    ++col;
+                    continue;
+                }
+
+                uint8_t start = col;
+                uint8_t end = col + 1;
+                for (uint8_t c = end; c < _cols && c - end <= MENUSYSTEM_TEXT_GRID_MAX_GAP; ++c) {
+                    if (frame[c] != shown[c])
+                        end = c + 1;
+                }
+
+                _backend.set_cursor(start, row);
+                _backend.write(frame + start, end - start);
+                memcpy(shown + start, frame + start, end - start);
+                col = end;
+            }
+        }
+    }
+
+private:
+    TextGridBackend& _backend;
+    char* _p_frame;
+    char* _p_shown;
+    uint8_t _cols;
+    uint8_t _rows;
+    mutable uint8_t _col;
+    mutable uint8_t _row;
+    bool _show_title;
+};
+
+//! \brief A TextGridRenderer for a display of COLS x ROWS characters
+//!
+//! \code
+//! class LcdBackend : public TextGridBackend {
+//!     void set_cursor(uint8_t col, uint8_t row) { lcd.setCursor(col, row); }
+//!     void write(const char* text, uint8_t length) { lcd.write((const uint8_t*) text, length); }
+//! };
+//! LcdBackend lcd_backend;
+//! StaticTextGridRenderer<16, 2> my_renderer(lcd_backend);
+//! \endcode
+//!
+//! \see TextGridRenderer
+template <uint8_t COLS, uint8_t ROWS>
+class StaticTextGridRenderer : public TextGridRenderer {
+    static_assert(COLS > 0 && ROWS > 0, "StaticTextGridRenderer needs at least one cell");
+public:
+    StaticTextGridRenderer(TextGridBackend& backend)
+    : TextGridRenderer(backend, COLS, ROWS, _frame, _shown) {
+    }
+
+private:
+    char _frame[COLS * ROWS];
+    char _shown[COLS * ROWS];
+};
+
+#endif // TEXT_GRID_RENDERER_H
@@ -22,7 +22,7 @@ public:
 	 *                       formatter will be used.
 	 */
 	ToggleMenuItem(const char* name, SelectFnPtr select_fn,const char* onString, const char* offString, bool state = false)
-        : MenuItem(name, select_fn), _state(state), _onString(onString), _offString(offString) {}
+        : MenuItem(name, select_fn, TYPE_TOGGLE_MENU_ITEM), _state(state), _onString(onString), _offString(offString) {}
 
 	void set_state(bool state) { _state = state; }
 	void set_state_on() { _state = true; }
@@ -36,15 +36,27 @@ public:
             return _offString;
     }
 	virtual void render(MenuComponentRenderer const& renderer) const {
-	MenuComponentRenderer2 const& my_renderer = static_cast<MenuComponentRenderer2 const&>(renderer);
-	my_renderer.render_toggle_menu_item(*this);
+	renderer.render_toggle_menu_item(*this);
 }
 
+	virtual uint8_t save_state(uint8_t* buffer, uint8_t size) const {
+		if (size < 1)
+			return 0;
+		buffer[0] = _state;
+		return 1;
+	}
+
+	virtual bool load_state(const uint8_t* buffer, uint8_t size) {
+		if (size != 1 || buffer[0] > 1)
+			return false;
+		_state = buffer[0];
+		return true;
+	}
+
 protected:
 	virtual Menu* select() {
         toggle_state();
-        if (_select_fn != nullptr)
-            _select_fn(this);
+        call_select_fn();
         return nullptr;
     }
 
@@ -0,0 +1,395 @@
+/**
+ * \file    menusystem-bench.cpp
+ * \brief   host micro-benchmarks for navigation, selection and rendering
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ *
+ * Usage: menusystem-bench [iterations]
+ *
+ * Prints one line per benchmark with the time and the number of heap
+ * allocations per operation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <deque>
+#include <new>
+#include <string>
+#include <vector>
+
+static size_t g_num_allocs = 0;
+
+static void* bench_realloc(void* ptr, size_t size)
+{
+    g_num_allocs++;
+    return realloc(ptr, size);
+}
+
+#define MENUSYSTEM_REALLOC bench_realloc
+#define MENUSYSTEM_FREE free
+#include "../src/MenuSystem.h"
+#include "../src/MenuIndex.h"
+#include "../src/StaticMenuRenderer.h"
+
+void* operator new(size_t size)
+{
+    g_num_allocs++;
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+////////////////////////////////////////////////////////////////////////////////
+// renderers
+
+// Written for every component drawn, so the compiler can't drop the calls
+static const char* volatile g_render_sink;
+
+static void render_sink(MenuComponent const& component)
+{
+    g_render_sink = component.get_name();
+}
+
+//! Draws nothing; measures the cost of the traversal itself
+class NullRenderer : public MenuComponentRenderer {
+public:
+    void render(Menu const& menu) const {
+        for (int i = 0; i < menu.get_num_components(); ++i)
+            menu.get_menu_component(i)->render(*this);
+    }
+    void render_menu_item(MenuItem const& menu_item) const { render_sink(menu_item); }
+    void render_back_menu_item(BackMenuItem const& menu_item) const { render_sink(menu_item); }
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const { render_sink(menu_item); }
+    void render_menu(Menu const& menu) const { render_sink(menu); }
+};
+
+//! Like NullRenderer, but dispatched with StaticMenuRenderer
+class NullStaticRenderer : public StaticMenuRenderer<NullStaticRenderer> {
+public:
+    void render(Menu const& menu) const {
+        for (int i = 0; i < menu.get_num_components(); ++i)
+            render_component(*menu.get_menu_component(i));
+    }
+    void draw_component(MenuComponent const& component) const { render_sink(component); }
+};
+
+//! Builds the text a serial console would print, like serial_nav's MyRenderer
+class StringRenderer : public MenuComponentRenderer {
+public:
+    void render(Menu const& menu) const {
+        _buffer = menu.get_name();
+        _buffer += '\n';
+        for (int i = 0; i < menu.get_num_components(); ++i) {
+            MenuComponent const* cp_m_comp = menu.get_menu_component(i);
+            cp_m_comp->render(*this);
+            if (cp_m_comp->is_current())
+                _buffer += "<<< ";
+            _buffer += '\n';
+        }
+    }
+    void render_menu_item(MenuItem const& menu_item) const { _buffer += menu_item.get_name(); }
+    void render_back_menu_item(BackMenuItem const& menu_item) const { _buffer += menu_item.get_name(); }
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {
+        _buffer += menu_item.get_name();
+        _buffer += menu_item.has_focus() ? '<' : '=';
+        _buffer += menu_item.get_formatted_value();
+    }
+    void render_menu(Menu const& menu) const { _buffer += menu.get_name(); }
+
+    size_t size() const { return _buffer.size(); }
+
+protected:
+    mutable std::string _buffer;
+};
+
+//! Like StringRenderer, but only builds the rows of the viewport
+class ViewportRenderer : public StringRenderer {
+public:
+    explicit ViewportRenderer(uint8_t rows) : _rows(rows) {}
+
+    void render(Menu const& menu) const {
+        _buffer = menu.get_name();
+        _buffer += '\n';
+        menu_index_t first = menu.get_first_visible();
+        menu_index_t last = first + menu.get_num_visible(_rows);
+        for (int i = first; i < last; ++i) {
+            MenuComponent const* cp_m_comp = menu.get_menu_component(i);
+            cp_m_comp->render(*this);
+            if (cp_m_comp->is_current())
+                _buffer += "<<< ";
+            _buffer += '\n';
+        }
+    }
+
+private:
+    uint8_t _rows;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// trees
+
+static std::vector<std::string> g_names;
+
+static const char* item_name(size_t i)
+{
+    while (g_names.size() <= i)
+        g_names.push_back("Item " + std::to_string(g_names.size()));
+    return g_names[i].c_str();
+}
+
+//! A root menu with num_items items, every fourth of them numeric
+class WideTree {
+public:
+    WideTree(MenuComponentRenderer const& renderer, size_t num_items) : ms(renderer) {
+        for (size_t i = 0; i < num_items; ++i) {
+            if (i % 4 == 3) {
+                numerics.emplace_back(item_name(i), nullptr, 5, 0, 10);
+                ms.get_root_menu().add_item(&numerics.back());
+            } else {
+                items.emplace_back(item_name(i), nullptr);
+                ms.get_root_menu().add_item(&items.back());
+            }
+        }
+    }
+
+    MenuSystem ms;
+    std::deque<MenuItem> items;
+    std::deque<NumericMenuItem> numerics;
+};
+
+//! A chain of depth menus, each holding one item and the next menu
+class DeepTree {
+public:
+    DeepTree(MenuComponentRenderer const& renderer, size_t depth) : ms(renderer) {
+        Menu* p_parent = &ms.get_root_menu();
+        for (size_t i = 0; i < depth; ++i) {
+            items.emplace_back(item_name(i), nullptr);
+            menus.emplace_back(item_name(i));
+            p_parent->add_item(&items.back());
+            p_parent->add_menu(&menus.back());
+            p_parent = &menus.back();
+        }
+        items.emplace_back(item_name(depth), nullptr);
+        p_parent->add_item(&items.back());
+    }
+
+    //! Walks from the root menu to the deepest menu
+    void descend() {
+        for (size_t i = 0; i < menus.size(); ++i) {
+            ms.next();
+            ms.select();
+        }
+    }
+
+    MenuSystem ms;
+    std::deque<MenuItem> items;
+    std::deque<Menu> menus;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// harness
+
+typedef std::chrono::steady_clock bench_clock;
+
+//! Runs fn(iterations) and reports the cost of a single operation
+template <typename Fn>
+static void bench(const char* name, size_t iterations, Fn fn)
+{
+    size_t allocs = g_num_allocs;
+    bench_clock::time_point start = bench_clock::now();
+    fn(iterations);
+    bench_clock::time_point end = bench_clock::now();
+    allocs = g_num_allocs - allocs;
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("%-32s %12.1f ns/op %10.2f allocs/op\n", name,
+           ns / iterations, (double) allocs / iterations);
+}
+
+static void bench_wide(size_t num_items, size_t iterations)
+{
+    char name[64];
+    NullRenderer null_renderer;
+    NullStaticRenderer null_static_renderer;
+    StringRenderer string_renderer;
+    WideTree null_tree(null_renderer, num_items);
+    WideTree null_static_tree(null_static_renderer, num_items);
+    WideTree string_tree(string_renderer, num_items);
+
+    snprintf(name, sizeof(name), "wide%zu/next", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            null_tree.ms.next(true);
+    });
+    snprintf(name, sizeof(name), "wide%zu/prev", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            null_tree.ms.prev(true);
+    });
+    snprintf(name, sizeof(name), "wide%zu/select", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            null_tree.ms.select();
+    });
+    snprintf(name, sizeof(name), "wide%zu/reset", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            null_tree.ms.reset();
+    });
+    snprintf(name, sizeof(name), "wide%zu/display-null", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            null_tree.ms.invalidate();
+            null_tree.ms.display();
+        }
+    });
+    snprintf(name, sizeof(name), "wide%zu/display-null-static", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            null_static_tree.ms.invalidate();
+            null_static_tree.ms.display();
+        }
+    });
+    snprintf(name, sizeof(name), "wide%zu/display-string", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            string_tree.ms.invalidate();
+            string_tree.ms.display();
+        }
+    });
+    snprintf(name, sizeof(name), "wide%zu/next+display-string", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            string_tree.ms.next(true);
+            string_tree.ms.display();
+        }
+    });
+
+    ViewportRenderer viewport_renderer(4);
+    WideTree viewport_tree(viewport_renderer, num_items);
+    viewport_tree.ms.set_viewport(4);
+    snprintf(name, sizeof(name), "wide%zu/next+display-viewport", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            viewport_tree.ms.next(true);
+            viewport_tree.ms.display();
+        }
+    });
+
+    // "Item 1" matches Item 1, Item 10 to 19, Item 100 to 199
+    StaticMenuFilter<255> filter;
+    null_tree.ms.set_filter(&filter);
+    snprintf(name, sizeof(name), "wide%zu/filter-type+clear", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; i += 2) {
+            null_tree.ms.filter_add_char('i');
+            null_tree.ms.filter_clear();
+        }
+    });
+    null_tree.ms.filter_add_char('i');
+    null_tree.ms.filter_add_char('t');
+    null_tree.ms.filter_add_char('e');
+    null_tree.ms.filter_add_char('m');
+    null_tree.ms.filter_add_char(' ');
+    null_tree.ms.filter_add_char('1');
+    snprintf(name, sizeof(name), "wide%zu/filter-next", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            null_tree.ms.next(true);
+    });
+    null_tree.ms.set_filter(nullptr);
+
+    MenuItem item("item", nullptr);
+    snprintf(name, sizeof(name), "wide%zu/add_component", num_items);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; i += num_items) {
+            Menu menu("menu");
+            for (size_t j = 0; j < num_items; ++j)
+                menu.add_item(&item);
+        }
+    });
+}
+
+static void bench_deep(size_t depth, size_t iterations)
+{
+    char name[64];
+    NullRenderer null_renderer;
+    DeepTree tree(null_renderer, depth);
+
+    snprintf(name, sizeof(name), "deep%zu/select+back", depth);
+    bench(name, iterations, [&](size_t n) {
+        tree.ms.reset();
+        tree.descend();
+        for (size_t i = 0; i < n; i += 2) {
+            tree.ms.back();
+            tree.ms.select();
+        }
+    });
+    snprintf(name, sizeof(name), "deep%zu/descend+reset", depth);
+    bench(name, iterations, [&](size_t n) {
+        tree.ms.reset();
+        for (size_t i = 0; i < n; i += 2 * depth + 1) {
+            tree.descend();
+            tree.ms.reset();
+        }
+    });
+    snprintf(name, sizeof(name), "deep%zu/reset", depth);
+    bench(name, iterations, [&](size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            tree.ms.reset();
+    });
+
+    // The deepest item, through the index instead of next() and select()
+    std::string path;
+    for (size_t i = 0; i <= depth; ++i) {
+        if (i != 0)
+            path += MENUSYSTEM_PATH_SEPARATOR;
+        path += item_name(i);
+    }
+    StaticMenuIndex<256> index;
+    index.build(tree.ms.get_root_menu());
+    std::vector<menu_index_t> indices(depth + 1);
+    index.get_indices(index.find(path.c_str()), indices.data(), indices.size());
+
+    snprintf(name, sizeof(name), "deep%zu/find-path", depth);
+    bench(name, iterations, [&](size_t n) {
+        // Keeps the compiler from dropping the lookups
+        volatile uint16_t id;
+        for (size_t i = 0; i < n; ++i)
+            id = index.find(path.c_str());
+        (void) id;
+    });
+    snprintf(name, sizeof(name), "deep%zu/jump+reset", depth);
+    bench(name, iterations, [&](size_t n) {
+        tree.ms.reset();
+        for (size_t i = 0; i < n; i += 2) {
+            tree.ms.jump_to(indices.data(), indices.size());
+            tree.ms.reset();
+        }
+    });
+}
+
+int main(int argc, const char * argv[])
+{
+    size_t iterations = 100000;
+    if (argc > 1)
+        iterations = strtoul(argv[1], nullptr, 0);
+    if (iterations < 1)
+        iterations = 1;
+
+    static const size_t widths[] = { 8, 64, 255 };
+    for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); ++i)
+        bench_wide(widths[i], iterations);
+
+    static const size_t depths[] = { 4, 16, 64 };
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i)
+        bench_deep(depths[i], iterations);
+
+    return 0;
+}
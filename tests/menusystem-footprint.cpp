@@ -0,0 +1,223 @@
+/**
+ * \file    menusystem-footprint.cpp
+ * \brief   host tool that reports the RAM taken by the menu classes and by
+ *          a menu tree
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ *
+ * Usage: menusystem-footprint
+ *
+ * Prints the size of every class of the library, then the size of every
+ * object of a menu definition and the heap it allocates when it's built.
+ * The configuration macros apply, so the effect of e.g.
+ * -DMENUSYSTEM_NO_SELECT_FN can be measured:
+ *
+ *     make footprint FOOTPRINT_FLAGS="-m32 -DMENUSYSTEM_NO_SELECT_FN"
+ *
+ * The sizes are those of the host compiler; -m32 comes close to 32 bit
+ * boards. On AVR pointers take 2 bytes and nothing is padded.
+ *
+ * The menu definition is the sample below unless FOOTPRINT_MENU names a
+ * header that provides the same three things:
+ *
+ *     make footprint FOOTPRINT_MENU=my_menu.h
+ *
+ * - the objects of the tree, as globals;
+ * - FOOTPRINT_OBJECTS(X), calling X(object) for each of them;
+ * - footprint_build(), which adds the components to the menus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+#define FOOTPRINT_MAX_BLOCKS 256
+
+struct Block {
+    void* ptr;
+    size_t size;
+};
+
+static Block g_blocks[FOOTPRINT_MAX_BLOCKS];
+static size_t g_num_blocks = 0;
+static size_t g_heap_size = 0;
+
+static void footprint_track(void* ptr, size_t size)
+{
+    if (ptr == nullptr)
+        return;
+    if (g_num_blocks == FOOTPRINT_MAX_BLOCKS) {
+        fprintf(stderr, "more than %d heap blocks\n", FOOTPRINT_MAX_BLOCKS);
+        exit(1);
+    }
+    g_blocks[g_num_blocks].ptr = ptr;
+    g_blocks[g_num_blocks].size = size;
+    g_num_blocks++;
+    g_heap_size += size;
+}
+
+static size_t footprint_untrack(void* ptr)
+{
+    for (size_t i = 0; i < g_num_blocks; ++i) {
+        if (g_blocks[i].ptr == ptr) {
+            size_t size = g_blocks[i].size;
+            g_heap_size -= size;
+            g_blocks[i] = g_blocks[--g_num_blocks];
+            return size;
+        }
+    }
+    return 0;
+}
+
+static void* footprint_realloc(void* ptr, size_t size)
+{
+    size_t old_size = footprint_untrack(ptr);
+    void* p = realloc(ptr, size);
+    if (p != nullptr)
+        footprint_track(p, size);
+    else
+        footprint_track(ptr, old_size); // ptr is still allocated
+    return p;
+}
+
+static void footprint_free(void* ptr)
+{
+    footprint_untrack(ptr);
+    free(ptr);
+}
+
+#define MENUSYSTEM_REALLOC footprint_realloc
+#define MENUSYSTEM_FREE footprint_free
+#include "../src/MenuSystem.h"
+#include "../src/DataSourceMenu.h"
+#include "../src/MenuSession.h"
+#include "../src/NumericDisplayMenuItem.h"
+#include "../src/NumericMenuItemT.h"
+#include "../src/TextEditMenuItem.h"
+#include "../src/ToggleMenuItem.h"
+
+// Counts the root menu of a MenuSystem
+void* operator new(size_t size)
+{
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    footprint_track(p, size);
+    return p;
+}
+
+void operator delete(void* p) noexcept { footprint_untrack(p); free(p); }
+void operator delete(void* p, size_t) noexcept { footprint_untrack(p); free(p); }
+
+////////////////////////////////////////////////////////////////////////////////
+// menu definition
+
+#ifdef FOOTPRINT_MENU
+#include FOOTPRINT_MENU
+#else
+
+class NullRenderer : public MenuComponentRenderer {
+public:
+    void render(Menu const& menu) const {}
+    void render_menu_item(MenuItem const& menu_item) const {}
+    void render_back_menu_item(BackMenuItem const& menu_item) const {}
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {}
+    void render_menu(Menu const& menu) const {}
+};
+
+// The tree of the serial_nav example
+NullRenderer my_renderer;
+MenuSystem ms(my_renderer);
+MenuItem mm_mi1("Level 1 - Item 1 (Item)", nullptr);
+MenuItem mm_mi2("Level 1 - Item 2 (Item)", nullptr);
+Menu mu1("Level 1 - Item 3 (Menu)");
+BackMenuItem mu1_mi0("Level 2 - Back (Item)", nullptr, &ms);
+MenuItem mu1_mi1("Level 2 - Item 1 (Item)", nullptr);
+NumericMenuItem mu1_mi2("Level 2 - Txt Item 2 (Item)", nullptr, 0, 0, 2, 1);
+NumericMenuItemT<int16_t> mu1_mi3("Level 2 - Cust Item 3 (Item)", nullptr, 80, 65, 90, 1);
+ToggleMenuItem mu1_mi4("Level 2 - Toggle (Item)", nullptr, "on", "off");
+
+#define FOOTPRINT_OBJECTS(X) \
+    X(ms) \
+    X(mm_mi1) \
+    X(mm_mi2) \
+    X(mu1) \
+    X(mu1_mi0) \
+    X(mu1_mi1) \
+    X(mu1_mi2) \
+    X(mu1_mi3) \
+    X(mu1_mi4)
+
+void footprint_build()
+{
+    ms.get_root_menu().add_item(&mm_mi1);
+    ms.get_root_menu().add_item(&mm_mi2);
+    ms.get_root_menu().add_menu(&mu1);
+    mu1.add_item(&mu1_mi0);
+    mu1.add_item(&mu1_mi1);
+    mu1.add_item(&mu1_mi2);
+    mu1.add_item(&mu1_mi3);
+    mu1.add_item(&mu1_mi4);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define PRINT_CLASS(T) printf("  %-32s %4u\n", #T, (unsigned) sizeof(T));
+#define PRINT_OBJECT(object) \
+    printf("  %-32s %4u\n", #object, (unsigned) sizeof(object)); \
+    static_size += sizeof(object);
+
+int main(int argc, char * argv[])
+{
+    printf("configuration:\n");
+    printf("  %-32s %4u\n", "sizeof(void*)", (unsigned) sizeof(void*));
+    printf("  %-32s %4u\n", "sizeof(menu_index_t)", (unsigned) sizeof(menu_index_t));
+#ifdef MENUSYSTEM_NO_SELECT_FN
+    printf("  %-32s %4s\n", "MENUSYSTEM_NO_SELECT_FN", "yes");
+#else
+    printf("  %-32s %4s\n", "MENUSYSTEM_NO_SELECT_FN", "no");
+#endif
+#ifdef MENUSYSTEM_INSTRUMENT
+    printf("  %-32s %4s\n", "MENUSYSTEM_INSTRUMENT", "yes");
+#else
+    printf("  %-32s %4s\n", "MENUSYSTEM_INSTRUMENT", "no");
+#endif
+
+    printf("\nclasses:\n");
+    PRINT_CLASS(MenuItem)
+    PRINT_CLASS(BackMenuItem)
+    PRINT_CLASS(NumericMenuItem)
+    PRINT_CLASS(NumericMenuItemT<uint8_t>)
+    PRINT_CLASS(NumericMenuItemT<int16_t>)
+    PRINT_CLASS(NumericMenuItemT<float>)
+    PRINT_CLASS(NumericDisplayMenuItem)
+    PRINT_CLASS(ToggleMenuItem)
+    PRINT_CLASS(TextEditMenuItem)
+    PRINT_CLASS(Menu)
+    PRINT_CLASS(StaticMenu<4>)
+    PRINT_CLASS(StaticDataSourceMenu<4>)
+    PRINT_CLASS(MenuChangeSet)
+    PRINT_CLASS(MenuSystem)
+    PRINT_CLASS(MenuCursor)
+    PRINT_CLASS(MenuSession)
+
+    // The root menus of MenuSystems are allocated before main()
+    size_t heap_before = g_heap_size;
+    footprint_build();
+
+    size_t static_size = 0;
+    printf("\nobjects:\n");
+    FOOTPRINT_OBJECTS(PRINT_OBJECT)
+
+    // Without the bookkeeping of the allocator, a few bytes per block
+    printf("\ntotals:\n");
+    printf("  %-32s %4u\n", "objects", (unsigned) static_size);
+    printf("  %-32s %4u (%u blocks, %u bytes by footprint_build)\n", "heap",
+           (unsigned) g_heap_size, (unsigned) g_num_blocks,
+           (unsigned) (g_heap_size - heap_before));
+    printf("  %-32s %4u\n", "total", (unsigned) (static_size + g_heap_size));
+    return 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * \file    menusystem-replay.cpp
+ * \brief   host tool that records a trace of a menu session and replays it
+ *          frame by frame against a tree
+ * \version 3.1.0
+ * \date    2026-10-16
+ * \copyright  Licensed under the MIT license (see LICENSE)
+ *
+ * Usage: menusystem-replay -r trace < commands
+ *        menusystem-replay trace
+ *
+ * With -r, the commands read from stdin drive the tree and are recorded
+ * into trace, each followed by a display():
+ *
+ *     n next      p prev      s select    b back      r reset
+ *     h home      e end       + move_by(10)           - move_by(-10)
+ *
+ * Without it, trace is replayed, whether it was recorded by this tool or
+ * by MenuRecorder on a board. Every recorded frame is compared with the
+ * one the replay renders, and the time of each call is reported per
+ * operation. The exit status is 1 if a frame differs, 2 on errors.
+ *
+ * The tree is the one of the serial_nav example unless REPLAY_MENU names
+ * a header that provides the same two things:
+ *
+ *     g++ -std=c++11 -DREPLAY_MENU='"my_menu.h"' menusystem-replay.cpp
+ *
+ * - the objects of the tree, as globals, with a MenuSystem ms built on
+ *   trace_renderer;
+ * - replay_build(), which adds the components to the menus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "../src/MenuSystem.h"
+#include "../src/MenuTrace.h"
+#include "../src/NumericMenuItemT.h"
+
+//! Does nothing; the frames are only compared by digest
+class NullRenderer : public MenuComponentRenderer {
+public:
+    void render(Menu const& menu) const {}
+    void render_menu_item(MenuItem const& menu_item) const {}
+    void render_back_menu_item(BackMenuItem const& menu_item) const {}
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {}
+    void render_menu(Menu const& menu) const {}
+};
+
+//! Reads a trace loaded in memory, so the replay doesn't time the file
+class BufferTraceReader : public MenuTraceReader {
+public:
+    explicit BufferTraceReader(std::vector<uint8_t> const& buffer) : _buffer(buffer), _pos(0) {}
+
+    bool read(uint8_t* data, uint8_t size) {
+        if (_buffer.size() - _pos < size)
+            return false;
+        memcpy(data, &_buffer[_pos], size);
+        _pos += size;
+        return true;
+    }
+
+    size_t get_pos() const { return _pos; }
+
+private:
+    std::vector<uint8_t> const& _buffer;
+    size_t _pos;
+};
+
+NullRenderer null_renderer;
+MenuTraceRenderer trace_renderer(null_renderer);
+
+////////////////////////////////////////////////////////////////////////////////
+// menu definition
+
+#ifdef REPLAY_MENU
+#include REPLAY_MENU
+#else
+
+// The tree of the serial_nav example
+MenuSystem ms(trace_renderer);
+MenuItem mm_mi1("Level 1 - Item 1 (Item)", nullptr);
+MenuItem mm_mi2("Level 1 - Item 2 (Item)", nullptr);
+Menu mu1("Level 1 - Item 3 (Menu)");
+BackMenuItem mu1_mi0("Level 2 - Back (Item)", nullptr, &ms);
+MenuItem mu1_mi1("Level 2 - Item 1 (Item)", nullptr);
+NumericMenuItem mu1_mi2("Level 2 - Txt Item 2 (Item)", nullptr, 0, 0, 2, 1);
+NumericMenuItemT<int16_t> mu1_mi3("Level 2 - Cust Item 3 (Item)", nullptr, 80, 65, 90, 1);
+ToggleMenuItem mu1_mi4("Level 2 - Toggle (Item)", nullptr, "on", "off");
+
+void replay_build()
+{
+    ms.get_root_menu().add_item(&mm_mi1);
+    ms.get_root_menu().add_item(&mm_mi2);
+    ms.get_root_menu().add_menu(&mu1);
+    mu1.add_item(&mu1_mi0);
+    mu1.add_item(&mu1_mi1);
+    mu1.add_item(&mu1_mi2);
+    mu1.add_item(&mu1_mi3);
+    mu1.add_item(&mu1_mi4);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int record(const char* path)
+{
+    MenuTraceFile file(path, "wb");
+    if (!file.is_open()) {
+        fprintf(stderr, "can't create %s\n", path);
+        return 2;
+    }
+    MenuTraceEncoder encoder(file);
+    trace_renderer.set_encoder(&encoder);
+    MenuRecorder recorder(ms, encoder);
+
+    unsigned num_commands = 0;
+    int c;
+    while ((c = getchar()) != EOF) {
+        switch (c) {
+        case 'n': recorder.next(); break;
+        case 'p': recorder.prev(); break;
+        case 's': recorder.select(); break;
+        case 'b': recorder.back(); break;
+        case 'r': recorder.reset(); break;
+        case 'h': recorder.home(); break;
+        case 'e': recorder.end(); break;
+        case '+': recorder.move_by(10); break;
+        case '-': recorder.move_by(-10); break;
+        case ' ': case '\t': case '\r': case '\n': continue;
+        default:
+            fprintf(stderr, "unknown command '%c'\n", c);
+            continue;
+        }
+        recorder.display();
+        num_commands++;
+    }
+    trace_renderer.set_encoder(nullptr);
+
+    if (encoder.get_num_failed() != 0) {
+        fprintf(stderr, "%u records couldn't be written to %s\n",
+                (unsigned) encoder.get_num_failed(), path);
+        return 2;
+    }
+    printf("%u commands, %u frames recorded\n", num_commands,
+           (unsigned) trace_renderer.get_num_frames());
+    return 0;
+}
+
+static const char* op_name(uint8_t op)
+{
+    static const char* names[] = {
+        "?", "next", "prev", "move_by", "move_to", "home", "end", "select",
+        "back", "reset", "jump_to", "display", "frame"
+    };
+    op &= ~TRACE_FLAG;
+    return op < sizeof(names) / sizeof(names[0]) ? names[op] : "?";
+}
+
+typedef std::chrono::steady_clock replay_clock;
+
+static int replay(const char* path)
+{
+    std::vector<uint8_t> buffer;
+    FILE* p_file = fopen(path, "rb");
+    if (p_file == nullptr) {
+        fprintf(stderr, "can't open %s\n", path);
+        return 2;
+    }
+    uint8_t chunk[4096];
+    size_t size;
+    while ((size = fread(chunk, 1, sizeof(chunk), p_file)) != 0)
+        buffer.insert(buffer.end(), chunk, chunk + size);
+    fclose(p_file);
+
+    struct OpStats {
+        unsigned long count;
+        double total_ns;
+        double max_ns;
+    };
+    OpStats stats[TRACE_FRAME + 1];
+    memset(stats, 0, sizeof(stats));
+
+    BufferTraceReader reader(buffer);
+    MenuTracePlayer player(ms, trace_renderer, reader);
+    MenuTracePlayer::StepResult result;
+    unsigned long num_steps = 0;
+    for (;;) {
+        size_t pos = reader.get_pos();
+        replay_clock::time_point start = replay_clock::now();
+        result = player.step();
+        double ns = std::chrono::duration<double, std::nano>(replay_clock::now() - start).count();
+        if (result == MenuTracePlayer::STEP_END || result == MenuTracePlayer::STEP_ERROR) {
+            if (result == MenuTracePlayer::STEP_ERROR)
+                fprintf(stderr, "invalid record at offset %lu\n", (unsigned long) pos);
+            break;
+        }
+
+        num_steps++;
+        if (result == MenuTracePlayer::STEP_MISMATCH)
+            printf("frame %lu differs (record %lu, offset %lu)\n",
+                   (unsigned long) player.get_num_frames(), num_steps, (unsigned long) pos);
+
+        uint8_t op = player.get_last_op() & ~TRACE_FLAG;
+        if (op <= TRACE_FRAME) {
+            stats[op].count++;
+            stats[op].total_ns += ns;
+            if (ns > stats[op].max_ns)
+                stats[op].max_ns = ns;
+        }
+    }
+
+    printf("%-12s %10s %12s %12s\n", "operation", "count", "avg ns", "max ns");
+    for (uint8_t op = TRACE_NEXT; op <= TRACE_FRAME; ++op) {
+        if (stats[op].count == 0)
+            continue;
+        printf("%-12s %10lu %12.1f %12.1f\n", op_name(op), stats[op].count,
+               stats[op].total_ns / stats[op].count, stats[op].max_ns);
+    }
+    printf("%lu records, %u frames, %u differ\n", num_steps,
+           (unsigned) player.get_num_frames(), (unsigned) player.get_num_mismatches());
+
+    if (result == MenuTracePlayer::STEP_ERROR)
+        return 2;
+    return player.get_num_mismatches() != 0 ? 1 : 0;
+}
+
+int main(int argc, char * argv[])
+{
+    replay_build();
+
+    if (argc == 3 && strcmp(argv[1], "-r") == 0)
+        return record(argv[2]);
+    if (argc == 2)
+        return replay(argv[1]);
+
+    fprintf(stderr, "usage: %s -r trace < commands\n"
+                    "       %s trace\n", argv[0], argv[0]);
+    return 2;
+}